@@ -0,0 +1,160 @@
+/**
+ *  Purpose:
+ *    microbenchmark of the oscillator kernels
+ *
+ *  compile:
+ *    cmake -S . -B build && cmake --build build   (in the repository root)
+ *
+ *  usage:
+ *    oscbench [-t seconds] [-o results.csv]
+ *    -t is the minimum time measured per case (default 0.01 s, best of
+ *    BENCH_REPEATS), results go to stdout unless -o is given
+ *
+ *  oscbench.c
+ *
+ *  Renders BENCH_VOICES oscillators spread over the audible range with
+ *  every interpolation mode (and every SIMD kernel the CPU supports for
+ *  linear), every table length from 256 to 65536 points (to see the L1/L2
+ *  cache effects of big tables), block sizes from 32 to 4096 frames, mono
+ *  and stereo. Each case is one CSV line:
+ *
+ *    mode,table_length,block,channels,ns_per_sample,voices_per_core
+ *
+ *  where ns_per_sample is per voice and output frame and voices_per_core is
+ *  how many such voices one core renders in real time at SAMPLE_RATE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "wavetable.h"
+
+#define SAMPLE_RATE (44100.)
+#define MIN_TABLE_BITS 8    // 256 points
+#define MAX_TABLE_BITS 16   // 65536 points
+#define MIN_BLOCK 32
+#define MAX_BLOCK 4096
+#define BENCH_VOICES 8
+#define BENCH_REPEATS 3
+
+typedef struct {
+  char name[32];
+  interpolation interp;
+  const osckernel *kernel;  // only for INTERP_LINEAR in stereo
+} mode;
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// best ns per voice sample over BENCH_REPEATS runs of at least minSeconds
+static double measure(const mode *m, const float *table, int tableBits,
+                      unsigned long block, int channels, float *out,
+                      double minSeconds) {
+  wave voices[BENCH_VOICES];
+  double start, elapsed, best = 0.;
+  unsigned long long frames;
+  int v, r;
+
+  for (v = 0; v < BENCH_VOICES; v++) {
+    // inharmonic spread from 55 Hz to about 7 kHz
+    waveInit(&voices[v], table, tableBits, 55. * (1 << v) * 1.0293,
+             .1, SAMPLE_RATE);
+    voices[v].interp = m->interp;
+    if (m->kernel != NULL) voices[v].kernel = m->kernel;
+  }
+
+  for (r = 0; r < BENCH_REPEATS; r++) {
+    frames = 0;
+    start = now();
+    do {
+      for (v = 0; v < BENCH_VOICES; v++) {
+        if (channels == 2)
+          waveRender(&voices[v], out, block);
+        else
+          waveRenderMono(&voices[v], out, block);
+      }
+      frames += block;
+      elapsed = now() - start;
+    } while (elapsed < minSeconds);
+    elapsed = elapsed * 1e9 / (frames * BENCH_VOICES);
+    if (r == 0 || elapsed < best) best = elapsed;
+  }
+
+  return best;
+}
+
+int main(int argc, char *argv[]) {
+  mode modes[INTERP_COUNT + 4];
+  int modeCount = 0, kernelCount, k, i, bits, channels, mono, opt;
+  const osckernel *kernels = oscKernelList(&kernelCount);
+  double minSeconds = .01, ns;
+  unsigned long block;
+  float *storage, *table, *out;
+  FILE *file = stdout;
+
+  while ((opt = getopt(argc, argv, "t:o:")) != -1) {
+    if (opt == 't') {
+      minSeconds = atof(optarg);
+    } else if (opt == 'o' && (file = fopen(optarg, "w")) != NULL) {
+      continue;
+    } else {
+      fprintf(stderr, "usage: %s [-t seconds] [-o results.csv]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  for (i = 0; i < INTERP_COUNT; i++) {
+    if (i == INTERP_LINEAR) {
+      for (k = 0; k < kernelCount; k++) {
+        snprintf(modes[modeCount].name, sizeof(modes[0].name), "linear-%s",
+                 kernels[k].name);
+        modes[modeCount].interp = INTERP_LINEAR;
+        modes[modeCount++].kernel = &kernels[k];
+      }
+    } else {
+      snprintf(modes[modeCount].name, sizeof(modes[0].name), "%s",
+               interpolationName(i));
+      modes[modeCount].interp = i;
+      modes[modeCount++].kernel = NULL;
+    }
+  }
+
+  storage = malloc(((1 << MAX_TABLE_BITS) + 2 * WAVETABLE_GUARD) *
+                   sizeof(float));
+  out = malloc(2 * MAX_BLOCK * sizeof(float));
+  if (storage == NULL || out == NULL) return 1;
+  table = storage + WAVETABLE_GUARD;
+
+  fprintf(file,
+          "mode,table_length,block,channels,ns_per_sample,voices_per_core\n");
+  for (bits = MIN_TABLE_BITS; bits <= MAX_TABLE_BITS; bits++) {
+    filltable(table, 1ul << bits);
+    for (block = MIN_BLOCK; block <= MAX_BLOCK; block *= 2) {
+      for (channels = 1; channels <= 2; channels++) {
+        for (i = 0; i < modeCount; i++) {
+          // the SIMD kernels are stereo only, mono linear is one plain loop
+          mono = channels == 1 && modes[i].kernel != NULL;
+          if (mono && modes[i].kernel != &kernels[0]) continue;
+          ns = measure(&modes[i], table, bits, block, channels, out,
+                       minSeconds);
+          fprintf(file, "%s,%lu,%lu,%d,%.4f,%.1f\n",
+                  mono ? "linear" : modes[i].name, 1ul << bits, block,
+                  channels, ns, 1e9 / (ns * SAMPLE_RATE));
+          fflush(file);
+        }
+      }
+    }
+  }
+
+  free(storage);
+  free(out);
+  if (file != stdout) fclose(file);
+  return 0;
+}
@@ -0,0 +1,206 @@
+/**
+ *  Purpose:
+ *    audio quality of the oscillator per interpolation mode and table size
+ *
+ *  compile:
+ *    cmake -S . -B build && cmake --build build   (in the repository root)
+ *
+ *  usage:
+ *    oscquality [-o results.csv]
+ *
+ *  oscquality.c
+ *
+ *  Renders a sine through the offline null device with sineCallback, takes
+ *  an FFT of the left channel and reports, in dB relative to the tone:
+ *
+ *    thdn      everything that is not the tone or DC (THD+N)
+ *    sfdr      the strongest single spur (spurious free dynamic range)
+ *    alias     the strongest spur that is an image of a harmonic above
+ *              Nyquist, and its frequency
+ *    vs_linear thdn minus the thdn of linear interpolation (wavetable2.c)
+ *              for the same table and tone; positive means worse
+ *
+ *  The capture is weighted with a 7-term Blackman-Harris window, whose
+ *  sidelobes sit near -180 dB, so the tones need not fall on FFT bins.
+ *  They are deliberately incommensurate with the table and the FFT length:
+ *  a coherent tone would make the phasor fraction repeat over a few values
+ *  and hide the interpolation error.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fft.h"
+#include "nulldevice.h"
+#include "wavetable.h"
+
+#define SAMPLE_RATE (44100.)
+#define BUFFER_SIZE 256
+#define MAX_AMP (0.5)
+#define ANALYSIS_BITS 16  // FFT length, 65536 points
+#define MIN_TABLE_BITS 8
+#define MAX_TABLE_BITS 16
+#define SETTLE_FRAMES 4096  // rendered and dropped before the capture
+#define TWOPI (6.283185307179586)
+#define LOBE_BINS 8  // half width of the window's main lobe, plus one
+
+static const double toneHz[] = {1000.3, 5333.7, 12345.9};
+#define TONES (sizeof(toneHz) / sizeof(toneHz[0]))
+
+// 7-term Blackman-Harris coefficients
+static const double harris[7] = {0.27105140069342,  -0.43329793923448,
+                                 0.21812299954311,  -0.06592544638803,
+                                 0.01081174209837,  -0.00077658482522,
+                                 0.00001388721735};
+
+typedef struct {
+  double thdn, sfdr, alias, aliasHz;
+} quality;
+
+static double decibels(double power, double reference) {
+  return 10. * log10((power + 1e-300) / reference);
+}
+
+static void fillWindow(double *window, unsigned long n) {
+  unsigned long i;
+  int k;
+
+  for (i = 0; i < n; i++) {
+    window[i] = 0.;
+    for (k = 0; k < 7; k++) window[i] += harris[k] * cos(TWOPI * k * i / n);
+  }
+}
+
+static double power(const double *re, const double *im, unsigned long k) {
+  return re[k] * re[k] + im[k] * im[k];
+}
+
+static void analyse(const fft *plan, const float *capture,
+                    const double *window, double hz, int tableBits,
+                    double *re, double *im, quality *q) {
+  const unsigned long n = plan->length;
+  const double binHz = SAMPLE_RATE / n;
+  const long tone = lround(hz / binHz);
+  unsigned long k, h, harmonics;
+  double signal = 0., peak = 0., rest = 0., spur = 0., alias = 0., p, f;
+  long b, c;
+
+  for (k = 0; k < n; k++) {
+    re[k] = capture[2 * k] * window[k];  // left channel
+    im[k] = 0.;
+  }
+  fftForward(plan, re, im);
+
+  for (k = LOBE_BINS; k <= n / 2; k++) {
+    p = power(re, im, k);
+    if (labs((long)k - tone) <= LOBE_BINS) {
+      signal += p;
+      if (p > peak) peak = p;
+    } else {
+      rest += p;
+      if (p > spur) spur = p;
+    }
+  }
+  q->thdn = decibels(rest, signal);
+  q->sfdr = -decibels(spur, peak);
+
+  // interpolation images are harmonics m * length +- 1 of the tone,
+  // above Nyquist they fold back into the audio band
+  q->alias = -400.;
+  q->aliasHz = 0.;
+  harmonics = 4ul << tableBits;
+  for (h = 2; h <= harmonics; h++) {
+    if (h * hz <= SAMPLE_RATE / 2) continue;  // a plain harmonic
+    f = fmod(h * hz, SAMPLE_RATE);
+    if (f > SAMPLE_RATE / 2) f = SAMPLE_RATE - f;
+    b = lround(f / binHz);
+    for (c = b - 2; c <= b + 2; c++) {
+      if (c < LOBE_BINS || c > (long)n / 2 || labs(c - tone) <= LOBE_BINS)
+        continue;
+      p = power(re, im, c);
+      if (p > alias) {
+        alias = p;
+        q->alias = decibels(p, peak);
+        q->aliasHz = f;
+      }
+    }
+  }
+}
+
+// render the tone offline into mem, SETTLE_FRAMES plus the capture
+static int render(wave *data, nullDeviceMemory *mem) {
+  nulldevice dev;
+  PaError err;
+
+  mem->frames = 0;
+  err = nullDeviceOpen(&dev, 2, SAMPLE_RATE, BUFFER_SIZE);
+  if (err != paNoError) return -1;
+  nullDeviceSetSink(&dev, nullDeviceMemorySink, mem);
+  err = nullDeviceRun(&dev, sineCallback, data,
+                      SETTLE_FRAMES + (1ul << ANALYSIS_BITS));
+  nullDeviceClose(&dev);
+
+  return err == paNoError ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+  nullDeviceMemory mem = {NULL, 0, 0};
+  quality q, reference[TONES];
+  wave osc;
+  fft plan;
+  double *re, *im, *window;
+  float *storage, *table;
+  FILE *file = stdout;
+  unsigned long t;
+  int bits, i, opt;
+
+  while ((opt = getopt(argc, argv, "o:")) != -1) {
+    if (opt != 'o' || (file = fopen(optarg, "w")) == NULL) {
+      fprintf(stderr, "usage: %s [-o results.csv]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  storage = malloc(((1 << MAX_TABLE_BITS) + 2 * WAVETABLE_GUARD) *
+                   sizeof(float));
+  re = malloc((1ul << ANALYSIS_BITS) * sizeof(double));
+  im = malloc((1ul << ANALYSIS_BITS) * sizeof(double));
+  window = malloc((1ul << ANALYSIS_BITS) * sizeof(double));
+  if (storage == NULL || re == NULL || im == NULL || window == NULL ||
+      fftInit(&plan, ANALYSIS_BITS) != 0)
+    return 1;
+  table = storage + WAVETABLE_GUARD;
+  fillWindow(window, 1ul << ANALYSIS_BITS);
+
+  fprintf(file,
+          "mode,table_length,frequency,thdn_db,sfdr_db,alias_db,alias_hz,"
+          "vs_linear_db\n");
+  for (bits = MIN_TABLE_BITS; bits <= MAX_TABLE_BITS; bits++) {
+    filltable(table, 1ul << bits);
+    // linear first, it is the reference for the other modes
+    for (i = INTERP_LINEAR; i < INTERP_LINEAR + INTERP_COUNT; i++) {
+      for (t = 0; t < TONES; t++) {
+        waveInit(&osc, table, bits, toneHz[t], MAX_AMP, SAMPLE_RATE);
+        osc.interp = (interpolation)(i % INTERP_COUNT);
+        if (render(&osc, &mem) != 0) return 1;
+        analyse(&plan, mem.samples + 2 * SETTLE_FRAMES, window, toneHz[t],
+                bits, re, im, &q);
+        if (osc.interp == INTERP_LINEAR) reference[t] = q;
+        fprintf(file, "%s,%lu,%.2f,%.2f,%.2f,%.2f,%.2f,%+.2f\n",
+                interpolationName(osc.interp), 1ul << bits, toneHz[t], q.thdn,
+                q.sfdr, q.alias, q.aliasHz, q.thdn - reference[t].thdn);
+      }
+    }
+  }
+
+  fftFree(&plan);
+  free(mem.samples);
+  free(storage);
+  free(re);
+  free(im);
+  free(window);
+  if (file != stdout) fclose(file);
+  return 0;
+}
@@ -0,0 +1,274 @@
+/**
+ *  Purpose:
+ *    representative offline render workload, for profile guided builds
+ *
+ *  compile:
+ *    cmake -S . -B build && cmake --build build   (in the repository root)
+ *
+ *  usage:
+ *    oscworkload [-t seconds] [-o results.csv]
+ *    -t is the audio rendered per case (default 10 s, best of
+ *    WORKLOAD_REPEATS), results go to stdout unless -o is given
+ *
+ *  oscworkload.c
+ *
+ *  Plays what the demos play, through the null device and the scheduler
+ *  as a stream would: for every interpolation mode a layer of
+ *  WORKLOAD_WAVES waves, half on the sine table and half on band-limited
+ *  saw mipmaps, retriggered at pseudo random frequencies every
+ *  WORKLOAD_NOTE seconds so the blocks split at note boundaries and the
+ *  amplitude ramps run; then the voice pool with WORKLOAD_VOICES voices,
+ *  again with a worker thread per further core when there are several,
+ *  the FM synth with WORKLOAD_FM_VOICES six operator voices, started
+ *  and stopped the same way, notes of WORKLOAD_PARTIALS partials on the
+ *  additive bank and of WORKLOAD_SPECTRAL partials on the inverse FFT
+ *  bank. Running it trains the profile of a
+ *  WAVETABLE_PGO=GENERATE build; each case is one CSV line,
+ *
+ *    case,ns_per_frame,realtime
+ *
+ *  with the callback time per output frame and the real time factor, which
+ *  tools/pgo.sh compares between a plain and a profile guided build.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "additive.h"
+#include "fm.h"
+#include "mipmap.h"
+#include "nulldevice.h"
+#include "scheduler.h"
+#include "spectral.h"
+#include "voicepool.h"
+#include "wavetable.h"
+#include "workerpool.h"
+
+#define SAMPLE_RATE (44100.)
+#define BUFFER_SIZE 256
+#define TABLE_BITS 11
+#define TABLE_LENGTH (1 << TABLE_BITS)
+#define WORKLOAD_WAVES 16
+#define WORKLOAD_VOICES 128
+#define WORKLOAD_FM_VOICES 64
+#define WORKLOAD_PARTIALS 1024
+#define WORKLOAD_SPECTRAL 16384
+#define WORKLOAD_NOTE (0.1)  // seconds between retriggers
+#define WORKLOAD_REPEATS 3
+
+// several waves mixed into one stereo stream
+typedef struct {
+  wave waves[WORKLOAD_WAVES];
+  float scratch[2 * BUFFER_SIZE];
+} layer;
+
+static float storage[TABLE_LENGTH + 2 * WAVETABLE_GUARD];
+static mipmap saw;
+static layer layers;
+static voicepool pool;
+static workerpool workers;
+static workerpool *poolWorkers;  // for the voice pool, or NULL
+static fmsynth fm;
+static fmpatch fmPatch;
+static additive bank;
+static additivepartial partials[WORKLOAD_PARTIALS];
+static spectralbank spectral;
+static scheduler sched;
+
+static int layerCallback(const void *inputBuffer, void *outputBuffer,
+                         unsigned long framesPerBuffer,
+                         const PaStreamCallbackTimeInfo *timeInfo,
+                         PaStreamCallbackFlags statusFlags, void *userData) {
+  layer *l = (layer *)userData;
+  float *out = (float *)outputBuffer;
+  unsigned long i;
+  int w;
+
+  memset(out, 0, 2 * framesPerBuffer * sizeof(float));
+  for (w = 0; w < WORKLOAD_WAVES; w++) {
+    waveRender(&l->waves[w], l->scratch, framesPerBuffer);
+    for (i = 0; i < 2 * framesPerBuffer; i++) out[i] += l->scratch[i];
+  }
+  return paContinue;
+}
+
+// the note key picks the wave of the layer
+static void layerEventHandler(const event *e, void *userData) {
+  waveEventHandler(e, &((layer *)userData)->waves[e->key]);
+}
+
+// deterministic frequencies from 40 Hz to about 10 kHz
+static float nextFrequency(unsigned long *seed) {
+  *seed = *seed * 1103515245ul + 12345ul;
+  return 40.f * (float)(1 << ((*seed >> 16) % 8)) *
+         (1.f + ((*seed >> 8) & 0xff) / 256.f);
+}
+
+// schedule one note per key starting at frame, lasting 3/4 of a note
+static int scheduleNotes(unsigned long long frame, int keys, float amplitude,
+                         unsigned long *seed) {
+  event e;
+  int k;
+
+  memset(&e, 0, sizeof(e));
+  for (k = 0; k < keys; k++) {
+    e.frame = frame + k;  // spread so blocks split at many frames
+    e.type = EVENT_NOTE_ON;
+    e.key = k;
+    e.value = nextFrequency(seed);
+    e.amplitude = amplitude;
+    if (schedulerSend(&sched, &e) != 0) return -1;
+    e.type = EVENT_NOTE_OFF;
+    e.frame += (unsigned long long)(.75 * WORKLOAD_NOTE * SAMPLE_RATE);
+    if (schedulerSend(&sched, &e) != 0) return -1;
+  }
+  return 0;
+}
+
+// best callback seconds of the scheduled case over WORKLOAD_REPEATS runs
+static double run(PaStreamCallback *callback, void *data, eventHandler handler,
+                  int keys, double seconds) {
+  const unsigned long long note =
+      (unsigned long long)(WORKLOAD_NOTE * SAMPLE_RATE);
+  unsigned long seed;
+  unsigned long long frame;
+  nulldevice dev;
+  double best = 0.;
+  int r, w;
+
+  for (r = 0; r < WORKLOAD_REPEATS; r++) {
+    seed = 1;
+    for (w = 0; w < WORKLOAD_WAVES; w++) {
+      layers.waves[w].amplitude = layers.waves[w].targetAmplitude = 0.f;
+      layers.waves[w].rampLeft = 0;
+    }
+    voicePoolInit(&pool, storage + WAVETABLE_GUARD, TABLE_BITS, SAMPLE_RATE,
+                  WORKLOAD_VOICES);
+    pool.bandlimited = &saw;
+    pool.workers = poolWorkers;
+    fmInit(&fm, storage + WAVETABLE_GUARD, TABLE_BITS, SAMPLE_RATE,
+           WORKLOAD_FM_VOICES);
+    fmSetPatch(&fm, &fmPatch);
+    additiveInit(&bank, SAMPLE_RATE);
+    additiveSetPartials(&bank, partials, WORKLOAD_PARTIALS);
+    if (schedulerInit(&sched, callback, data, handler, 2, SAMPLE_RATE) != 0 ||
+        nullDeviceOpen(&dev, 2, SAMPLE_RATE, BUFFER_SIZE) != paNoError) {
+      fprintf(stderr, "Error: out of memory.\n");
+      exit(1);
+    }
+    // a note at a time, so the inbox never holds more than one round
+    for (frame = 0; frame < seconds * SAMPLE_RATE; frame += note) {
+      if (scheduleNotes(frame, keys, .5f / keys, &seed) != 0 ||
+          nullDeviceRun(&dev, schedulerCallback, &sched, note) != paNoError)
+        break;
+    }
+    if (r == 0 || dev.callbackSeconds < best) best = dev.callbackSeconds;
+    nullDeviceClose(&dev);
+    schedulerFree(&sched);
+  }
+  return best;
+}
+
+static void report(FILE *file, const char *name, double callbackSeconds,
+                   double seconds) {
+  fprintf(file, "%s,%.2f,%.1f\n", name,
+          callbackSeconds * 1e9 / (seconds * SAMPLE_RATE),
+          seconds / callbackSeconds);
+  fflush(file);
+}
+
+int main(int argc, char *argv[]) {
+  FILE *file = stdout;
+  double seconds = 10., t;
+  long cores;
+  char name[32];
+  int opt, i, w;
+
+  while ((opt = getopt(argc, argv, "t:o:")) != -1) {
+    if (opt == 't') {
+      seconds = atof(optarg);
+    } else if (opt == 'o') {
+      file = fopen(optarg, "w");
+      if (file == NULL) {
+        fprintf(stderr, "Error: cannot open %s.\n", optarg);
+        return 1;
+      }
+    } else {
+      fprintf(stderr, "usage: %s [-t seconds] [-o results.csv]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  filltable(storage + WAVETABLE_GUARD, TABLE_LENGTH);
+  if (mipmapInitWaveform(&saw, WAVEFORM_SAW, TABLE_BITS) != 0) {
+    fprintf(stderr, "Error: cannot build the saw tables.\n");
+    return 1;
+  }
+
+  fprintf(file, "case,ns_per_frame,realtime\n");
+  for (i = 0; i < INTERP_COUNT; i++) {
+    for (w = 0; w < WORKLOAD_WAVES; w++) {
+      waveInit(&layers.waves[w], storage + WAVETABLE_GUARD, TABLE_BITS, 440.f,
+               0.f, SAMPLE_RATE);
+      layers.waves[w].interp = (interpolation)i;
+      if (w % 2 == 1) layers.waves[w].bandlimited = &saw;
+    }
+    t = run(layerCallback, &layers, layerEventHandler, WORKLOAD_WAVES,
+            seconds);
+    snprintf(name, sizeof(name), "layer-%s",
+             interpolationName((interpolation)i));
+    report(file, name, t, seconds);
+  }
+
+  t = run(voicePoolCallback, &pool, voicePoolEventHandler, WORKLOAD_VOICES,
+          seconds);
+  report(file, "voicepool", t, seconds);
+
+  // the same shared with the other cores, bit identical
+  cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores > WORKERPOOL_MAX_THREADS + 1) cores = WORKERPOOL_MAX_THREADS + 1;
+  if (cores > 1 && workerPoolInit(&workers, (int)cores - 1, NULL) == 0) {
+    poolWorkers = &workers;
+    t = run(voicePoolCallback, &pool, voicePoolEventHandler, WORKLOAD_VOICES,
+            seconds);
+    snprintf(name, sizeof(name), "voicepool-%ldt", cores);
+    report(file, name, t, seconds);
+    poolWorkers = NULL;
+    workerPoolFree(&workers);
+  }
+
+  // an electric piano like patch: two stacks, feedback on op 6
+  fmPatchInit(&fmPatch, FM_ALGO_PAIR_STACK);
+  fmPatch.ratio[1] = 14.f;
+  fmPatch.ratio[3] = 1.f;
+  fmPatch.ratio[4] = 3.f;
+  fmPatch.feedback = 1.f;
+  t = run(fmCallback, &fm, fmEventHandler, WORKLOAD_FM_VOICES, seconds);
+  report(file, "fm", t, seconds);
+
+  // a stiff string: slightly sharp partials, the high ones dying first
+  for (i = 0; i < WORKLOAD_PARTIALS; i++) {
+    partials[i].ratio = (i + 1) * (1.f + .0002f * i);
+    partials[i].amplitude = .3f / (i + 1);
+    partials[i].decay = 2.f / (i + 1);
+  }
+  t = run(additiveCallback, &bank, additiveEventHandler, 1, seconds);
+  report(file, "additive", t, seconds);
+
+  // a dense inharmonic cloud, mostly below Nyquist from the lowest notes
+  if (spectralInit(&spectral, SPECTRAL_FRAME_BITS, WORKLOAD_SPECTRAL,
+                   SAMPLE_RATE) != 0) {
+    fprintf(stderr, "Error: out of memory.\n");
+    return 1;
+  }
+  for (i = 0; i < WORKLOAD_SPECTRAL; i++)
+    spectralSetPartial(&spectral, i, 1.f + .01f * i, 1.f / WORKLOAD_SPECTRAL);
+  t = run(spectralCallback, &spectral, spectralEventHandler, 1, seconds);
+  report(file, "spectral", t, seconds);
+  spectralFree(&spectral);
+
+  mipmapFree(&saw);
+  if (file != stdout) fclose(file);
+  return 0;
+}
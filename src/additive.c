@@ -0,0 +1,281 @@
+/**
+ *  Purpose:
+ *    additive oscillator bank, see additive.h
+ *
+ *  additive.c
+ *
+ *  The lanes are a GCC vector type of ADDITIVE_LANES floats, which the
+ *  compiler maps onto SSE2 or NEON registers. The same body is compiled a
+ *  second time for AVX2 with a target attribute and picked at run time;
+ *  without FMA contraction both give bit identical output.
+ */
+
+#include "additive.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ADDITIVE_X86 1
+#endif
+
+#define TWOPI (6.283185307179586)
+
+static void renderGeneric(additive *a, unsigned long frames);
+#if defined(ADDITIVE_X86)
+static void renderAvx2(additive *a, unsigned long frames);
+#endif
+
+void additiveInit(additive *a, double sampleRate) {
+  memset(a, 0, sizeof(*a));
+  a->sampleRate = sampleRate;
+  a->attack = .005f;
+  a->release = .2f;
+  a->stage = ADDITIVE_SILENT;
+  a->kernel = renderGeneric;
+#if defined(ADDITIVE_X86)
+  a->kernelName = "sse2";
+  if (__builtin_cpu_supports("avx2")) {
+    a->kernel = renderAvx2;
+    a->kernelName = "avx2";
+  }
+#else
+  a->kernelName = "generic";
+#endif
+}
+
+static int compareRatio(const void *x, const void *y) {
+  float rx = ((const additivepartial *)x)->ratio;
+  float ry = ((const additivepartial *)y)->ratio;
+
+  return (rx > ry) - (rx < ry);
+}
+
+int additiveSetPartials(additive *a, const additivepartial *partials,
+                        int count) {
+  additivepartial *sorted;
+  int i;
+
+  if (count < 0 || count > ADDITIVE_MAX_PARTIALS) return -1;
+  sorted = malloc((count > 0 ? count : 1) * sizeof(*sorted));
+  if (sorted == NULL) return -1;
+  memcpy(sorted, partials, count * sizeof(*sorted));
+  qsort(sorted, count, sizeof(*sorted), compareRatio);
+
+  for (i = 0; i < ADDITIVE_MAX_PARTIALS; i++) {
+    a->ratio[i] = a->peak[i] = a->level[i] = a->step[i] = 0.f;
+    a->startSin[i] = a->startCos[i] = a->sine[i] = a->cosine[i] = 0.f;
+    a->decayFactor[i] = 1.f;
+  }
+  for (i = 0; i < count; i++) {
+    a->ratio[i] = sorted[i].ratio;
+    a->peak[i] = sorted[i].amplitude;
+    if (sorted[i].decay > 0.f)
+      a->decayFactor[i] = (float)exp(
+          -ADDITIVE_BLOCK / (sorted[i].decay * a->sampleRate));
+    a->startSin[i] = (float)sin(TWOPI * sorted[i].phase);
+    a->startCos[i] = (float)cos(TWOPI * sorted[i].phase);
+  }
+  free(sorted);
+  a->count = count;
+  a->stage = ADDITIVE_SILENT;
+  additiveSetFrequency(a, a->frequency);
+  return 0;
+}
+
+void additiveSetFrequency(additive *a, float frequency) {
+  const double nyquist = .5 * a->sampleRate;
+  double w;
+  int i;
+
+  a->frequency = frequency;
+  // sorted by ratio, so the partials above Nyquist are the tail
+  a->belowNyquist = 0;
+  while (a->belowNyquist < a->count &&
+         frequency * a->ratio[a->belowNyquist] < nyquist)
+    a->belowNyquist++;
+  a->audible = (a->belowNyquist + ADDITIVE_LANES - 1) & ~(ADDITIVE_LANES - 1);
+
+  for (i = 0; i < a->audible; i++) {
+    w = TWOPI * frequency * a->ratio[i] / a->sampleRate;
+    a->rotateSin[i] = (float)sin(w);
+    a->rotateCos[i] = (float)cos(w);
+  }
+  // culled partials stop at once rather than alias for a block, and stay
+  // silent until the next note
+  for (i = a->belowNyquist; i < a->count; i++)
+    a->level[i] = a->step[i] = 0.f;
+}
+
+void additiveNoteOn(additive *a, float frequency, float amplitude) {
+  int i;
+
+  a->amplitude = amplitude;
+  additiveSetFrequency(a, frequency);
+  for (i = 0; i < a->count; i++) {
+    a->sine[i] = a->startSin[i];
+    a->cosine[i] = a->startCos[i];
+    a->level[i] = a->step[i] = 0.f;
+  }
+  a->stage = ADDITIVE_ATTACK;
+  a->attackBlocks = (int)(a->attack * a->sampleRate / ADDITIVE_BLOCK + .5);
+  if (a->attackBlocks < 1) a->attackBlocks = 1;
+  a->attackDone = 0;
+  a->blockLeft = 0;
+}
+
+void additiveNoteOff(additive *a) {
+  if (a->stage == ADDITIVE_SILENT) return;
+  a->stage = ADDITIVE_RELEASE;
+  a->releaseGain = 1.f;
+}
+
+// the level every partial reaches at the end of the next block
+static void envelopes(additive *a) {
+  const float release =
+      a->release > 0.f
+          ? (float)exp(-ADDITIVE_BLOCK / (a->release * a->sampleRate))
+          : 0.f;
+  const float scale = 1.f / ADDITIVE_BLOCK;
+  float attack, next;
+  int i;
+
+  switch (a->stage) {
+    case ADDITIVE_ATTACK:
+      attack = a->amplitude * (a->attackDone + 1) / a->attackBlocks;
+      for (i = 0; i < a->belowNyquist; i++)
+        a->step[i] = (attack * a->peak[i] - a->level[i]) * scale;
+      if (++a->attackDone == a->attackBlocks) a->stage = ADDITIVE_DECAY;
+      break;
+    case ADDITIVE_DECAY:
+      for (i = 0; i < a->belowNyquist; i++) {
+        next = a->level[i] * a->decayFactor[i];
+        a->step[i] = (next - a->level[i]) * scale;
+      }
+      break;
+    case ADDITIVE_RELEASE:
+      for (i = 0; i < a->belowNyquist; i++) {
+        next = a->level[i] * a->decayFactor[i] * release;
+        a->step[i] = (next - a->level[i]) * scale;
+      }
+      a->releaseGain *= release;
+      if (a->releaseGain < ADDITIVE_SILENCE) a->stage = ADDITIVE_SILENT;
+      break;
+    case ADDITIVE_SILENT:
+      break;
+  }
+}
+
+// ADDITIVE_LANES floats as one GCC/Clang vector, lowered to whatever the
+// target has (two SSE2 or NEON registers, one AVX register)
+typedef float lanevector __attribute__((vector_size(4 * ADDITIVE_LANES)));
+
+// unaligned moves between the arrays and the vectors; macros, since a
+// function returning a vector would have a different ABI under AVX
+#define LOAD(v, from) memcpy(&(v), (from), sizeof(lanevector))
+#define STORE(to, v) memcpy((to), &(v), sizeof(lanevector))
+
+// ADDITIVE_LANES partials at a time over frames, summed per lane into
+// a->lanes
+static inline __attribute__((always_inline)) void renderLanes(
+    additive *a, unsigned long frames) {
+  lanevector s, c, rs, rc, lv, st, t, g, sum;
+  unsigned long i;
+  int p;
+
+  memset(a->lanes, 0, sizeof(a->lanes));
+  for (p = 0; p < a->audible; p += ADDITIVE_LANES) {
+    LOAD(s, a->sine + p);
+    LOAD(c, a->cosine + p);
+    LOAD(rs, a->rotateSin + p);
+    LOAD(rc, a->rotateCos + p);
+    LOAD(lv, a->level + p);
+    LOAD(st, a->step + p);
+    for (i = 0; i < frames; i++) {
+      LOAD(sum, a->lanes[i]);
+      sum += lv * s;
+      STORE(a->lanes[i], sum);
+      t = s * rc + c * rs;
+      c = c * rc - s * rs;
+      s = t;
+      lv += st;
+    }
+    // back onto the unit circle, g ~ 1 / |(s, c)| to first order
+    g = 1.5f - .5f * (s * s + c * c);
+    s *= g;
+    c *= g;
+    STORE(a->sine + p, s);
+    STORE(a->cosine + p, c);
+    STORE(a->level + p, lv);
+  }
+}
+
+static void renderGeneric(additive *a, unsigned long frames) {
+  renderLanes(a, frames);
+}
+
+#if defined(ADDITIVE_X86)
+__attribute__((target("avx2"))) static void renderAvx2(additive *a,
+                                                       unsigned long frames) {
+  renderLanes(a, frames);
+}
+#endif
+
+void additiveRender(additive *a, float *out, unsigned long frames) {
+  unsigned long i, n;
+  float y;
+  int l;
+
+  while (frames > 0) {
+    if (a->blockLeft == 0) {
+      envelopes(a);
+      a->blockLeft = ADDITIVE_BLOCK;
+    }
+    n = frames < (unsigned long)a->blockLeft ? frames
+                                              : (unsigned long)a->blockLeft;
+
+    if (a->stage == ADDITIVE_SILENT) {
+      memset(out, 0, 2 * n * sizeof(float));
+    } else {
+      a->kernel(a, n);
+      for (i = 0; i < n; i++) {
+        y = 0.f;
+        for (l = 0; l < ADDITIVE_LANES; l++) y += a->lanes[i][l];
+        out[2 * i] = y;      // left channel
+        out[2 * i + 1] = y;  // right channel
+      }
+    }
+    out += 2 * n;
+    frames -= n;
+    a->blockLeft -= (int)n;
+  }
+}
+
+void additiveEventHandler(const event *e, void *userData) {
+  additive *a = (additive *)userData;
+
+  switch (e->type) {
+    case EVENT_NOTE_ON:
+      additiveNoteOn(a, e->value, e->amplitude);
+      break;
+    case EVENT_NOTE_OFF:
+      additiveNoteOff(a);
+      break;
+    case EVENT_PARAM:
+      if (e->key == PARAM_FREQUENCY)
+        additiveSetFrequency(a, e->value);
+      else if (e->key == PARAM_AMPLITUDE)
+        a->amplitude = e->value;
+      break;
+  }
+}
+
+int additiveCallback(const void *inputBuffer, void *outputBuffer,
+                     unsigned long framesPerBuffer,
+                     const PaStreamCallbackTimeInfo *timeInfo,
+                     PaStreamCallbackFlags statusFlags, void *userData) {
+  additiveRender((additive *)userData, (float *)outputBuffer,
+                 framesPerBuffer);
+  return paContinue;
+}
@@ -0,0 +1,111 @@
+/**
+ *  Purpose:
+ *    additive oscillator bank of recursive sine generators
+ *
+ *  additive.h
+ *
+ *  Plays one note as a sum of up to ADDITIVE_MAX_PARTIALS sinusoids, each
+ *  at a ratio of the note frequency. No table is read: every partial is a
+ *  coupled form oscillator, a rotation of its (sin, cos) pair by the angle
+ *  of one sample,
+ *
+ *    s' = s cos w + c sin w,   c' = c cos w - s sin w
+ *
+ *  which costs four multiplies and two adds per partial and sample. The
+ *  pair is pulled back onto the unit circle once per block, so rounding
+ *  never lets the amplitude drift.
+ *
+ *  The state is a structure of arrays and ADDITIVE_LANES partials are
+ *  advanced together, one per SIMD lane, summed per lane over a block and
+ *  across lanes once at the end. Each partial has its own envelope, a
+ *  linear attack to its amplitude then an exponential decay with its own
+ *  time, and a common release; envelopes are evaluated every block and
+ *  ramped linearly within it. Partials are kept sorted by ratio, so those
+ *  at or above Nyquist for the current note are a tail that is skipped.
+ */
+
+#ifndef ADDITIVE_H
+#define ADDITIVE_H
+
+#include "portaudio.h"
+#include "scheduler.h"
+
+#define ADDITIVE_MAX_PARTIALS 4096
+#define ADDITIVE_LANES 8   // partials advanced together
+#define ADDITIVE_BLOCK 64  // frames per envelope step
+#define ADDITIVE_SILENCE (1e-6f)  // release gain where the note stops
+
+typedef struct {
+  float ratio;      // frequency as a multiple of the note
+  float amplitude;  // peak of the envelope
+  float decay;      // time constant of the decay in seconds, 0 sustains
+  float phase;      // start phase in cycles
+} additivepartial;
+
+typedef enum {
+  ADDITIVE_ATTACK,
+  ADDITIVE_DECAY,
+  ADDITIVE_RELEASE,
+  ADDITIVE_SILENT  // released below ADDITIVE_SILENCE, nothing is rendered
+} adstage;
+
+typedef struct additive additive;
+// renders frames of the audible partials into lanes
+typedef void (*additivekernel)(additive *a, unsigned long frames);
+
+struct additive {
+  // per partial, sorted by ratio, [count, ADDITIVE_MAX_PARTIALS) unused
+  float ratio[ADDITIVE_MAX_PARTIALS];
+  float peak[ADDITIVE_MAX_PARTIALS];
+  float decayFactor[ADDITIVE_MAX_PARTIALS];  // per block, 1 sustains
+  float startSin[ADDITIVE_MAX_PARTIALS];
+  float startCos[ADDITIVE_MAX_PARTIALS];
+  float sine[ADDITIVE_MAX_PARTIALS];  // oscillator state
+  float cosine[ADDITIVE_MAX_PARTIALS];
+  float rotateSin[ADDITIVE_MAX_PARTIALS];  // sin w, cos w of one sample
+  float rotateCos[ADDITIVE_MAX_PARTIALS];
+  float level[ADDITIVE_MAX_PARTIALS];  // envelope now
+  float step[ADDITIVE_MAX_PARTIALS];   // envelope change per sample
+  int count;
+  int belowNyquist;  // partials under half the sample rate at this note
+  int audible;       // the same rounded up to ADDITIVE_LANES, rendered
+
+  float frequency;
+  float amplitude;
+  float attack;   // seconds
+  float release;  // seconds
+  adstage stage;
+  int attackBlocks;    // blocks of the attack
+  int attackDone;      // blocks of it played
+  float releaseGain;   // product of the release factors so far
+  int blockLeft;       // frames until the envelopes are evaluated again
+  double sampleRate;
+  additivekernel kernel;   // for the vector width this CPU has
+  const char *kernelName;  // of that width, for display
+
+  float lanes[ADDITIVE_BLOCK][ADDITIVE_LANES];  // per lane sums of a block
+};
+
+void additiveInit(additive *a, double sampleRate);
+// copies and sorts the partials, -1 if there are more than the maximum
+int additiveSetPartials(additive *a, const additivepartial *partials,
+                        int count);
+// keeps the oscillators running, for glides and vibrato
+void additiveSetFrequency(additive *a, float frequency);
+// restarts every partial at its start phase and envelope
+void additiveNoteOn(additive *a, float frequency, float amplitude);
+void additiveNoteOff(additive *a);
+// render interleaved stereo
+void additiveRender(additive *a, float *out, unsigned long frames);
+
+// eventHandler: note on and off, PARAM_FREQUENCY, and PARAM_AMPLITUDE for
+// the attacks that follow
+void additiveEventHandler(const event *e, void *userData);
+
+// PaStreamCallback rendering the additive passed as userData
+int additiveCallback(const void *inputBuffer, void *outputBuffer,
+                     unsigned long framesPerBuffer,
+                     const PaStreamCallbackTimeInfo *timeInfo,
+                     PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // ADDITIVE_H
@@ -0,0 +1,22 @@
+/**
+ *  Purpose:
+ *    wavetables generated at build time, see builtin.h
+ *
+ *  builtin.c
+ */
+
+#include "builtin.h"
+
+#include <string.h>
+
+const float *builtinSine(void) { return builtinSineStorage + WAVETABLE_GUARD; }
+
+void builtinMipmap(mipmap *m, waveform shape) {
+  int l;
+
+  memset(m, 0, sizeof(*m));
+  m->tableBits = BUILTIN_TABLE_BITS;
+  m->levels = BUILTIN_TABLE_BITS;
+  for (l = 0; l < m->levels; l++)
+    m->level[l] = builtinMipmapStorage[shape][l] + WAVETABLE_GUARD;
+}
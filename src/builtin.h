@@ -0,0 +1,41 @@
+/**
+ *  Purpose:
+ *    wavetables generated at build time
+ *
+ *  builtin.h
+ *
+ *  filltable and mipmapInitWaveform compute their tables at startup, a
+ *  sin() or an inverse FFT per point. The tables used by the demos are
+ *  instead computed once by tools/gentables.c while building and compiled
+ *  in as const arrays: they live in read-only data, cost nothing at startup
+ *  and their pages are shared by every process running the same binary
+ *  (or linking the same shared libwavetable).
+ *
+ *  The table length is fixed when building, BUILTIN_TABLE_BITS is set by
+ *  the WAVETABLE_BUILTIN_BITS cmake option. The values are those of
+ *  filltable and mipmapInitWaveform at that length.
+ */
+
+#ifndef BUILTIN_H
+#define BUILTIN_H
+
+#include "interp.h"
+#include "mipmap.h"
+
+#ifndef BUILTIN_TABLE_BITS
+#define BUILTIN_TABLE_BITS 10
+#endif
+#define BUILTIN_TABLE_LENGTH (1 << BUILTIN_TABLE_BITS)
+#define BUILTIN_STRIDE (BUILTIN_TABLE_LENGTH + 2 * WAVETABLE_GUARD)
+
+// generated, the tables start WAVETABLE_GUARD floats into each row
+extern const float builtinSineStorage[BUILTIN_STRIDE];
+extern const float builtinMipmapStorage[WAVEFORM_COUNT][BUILTIN_TABLE_BITS]
+                                       [BUILTIN_STRIDE];
+
+// the sine of filltable, BUILTIN_TABLE_LENGTH points
+const float *builtinSine(void);
+// point m at the mipmap of mipmapInitWaveform for shape, nothing to free
+void builtinMipmap(mipmap *m, waveform shape);
+
+#endif  // BUILTIN_H
@@ -0,0 +1,130 @@
+/**
+ *  Purpose:
+ *    callback timing and CPU load instrumentation, see callbackstats.h
+ *
+ *  callbackstats.c
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "callbackstats.h"
+
+#include <string.h>
+#include <time.h>
+
+// single writer counters: a plain relaxed load and store, no locked add
+static void add(atomic_ullong *counter, unsigned long long value) {
+  atomic_store_explicit(
+      counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+      memory_order_relaxed);
+}
+
+void callbackStatsInit(callbackstats *stats, unsigned long framesPerBuffer,
+                       double sampleRate) {
+  int k;
+
+  stats->deadline = framesPerBuffer / sampleRate;
+  atomic_init(&stats->callbacks, 0);
+  atomic_init(&stats->deadlineMisses, 0);
+  atomic_init(&stats->underflows, 0);
+  atomic_init(&stats->overflows, 0);
+  atomic_init(&stats->totalNanoseconds, 0);
+  atomic_init(&stats->maxNanoseconds, 0);
+  for (k = 0; k < CALLBACKSTATS_BUCKETS; k++)
+    atomic_init(&stats->histogram[k], 0);
+}
+
+unsigned long long callbackStatsNow(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void callbackStatsRecord(callbackstats *stats, unsigned long long nanoseconds,
+                         PaStreamCallbackFlags statusFlags) {
+  int k = 0;
+
+  while (k < CALLBACKSTATS_BUCKETS - 1 && (nanoseconds >> (k + 1)) != 0) k++;
+  add(&stats->histogram[k], 1);
+  add(&stats->callbacks, 1);
+  add(&stats->totalNanoseconds, nanoseconds);
+  if (nanoseconds > atomic_load_explicit(&stats->maxNanoseconds,
+                                         memory_order_relaxed))
+    atomic_store_explicit(&stats->maxNanoseconds, nanoseconds,
+                          memory_order_relaxed);
+  if (nanoseconds * 1e-9 > stats->deadline) add(&stats->deadlineMisses, 1);
+  if (statusFlags & (paInputUnderflow | paOutputUnderflow))
+    add(&stats->underflows, 1);
+  if (statusFlags & (paInputOverflow | paOutputOverflow))
+    add(&stats->overflows, 1);
+}
+
+void callbackStatsSnapshot(callbackstats *stats,
+                           callbackstatsSnapshot *snapshot) {
+  int k;
+
+  snapshot->deadline = stats->deadline;
+  snapshot->callbacks = atomic_load(&stats->callbacks);
+  snapshot->deadlineMisses = atomic_load(&stats->deadlineMisses);
+  snapshot->underflows = atomic_load(&stats->underflows);
+  snapshot->overflows = atomic_load(&stats->overflows);
+  snapshot->totalNanoseconds = atomic_load(&stats->totalNanoseconds);
+  snapshot->maxNanoseconds = atomic_load(&stats->maxNanoseconds);
+  for (k = 0; k < CALLBACKSTATS_BUCKETS; k++)
+    snapshot->histogram[k] = atomic_load(&stats->histogram[k]);
+  snapshot->cpuLoad = -1.;
+}
+
+void callbackStatsDelta(const callbackstatsSnapshot *now,
+                        const callbackstatsSnapshot *before,
+                        callbackstatsSnapshot *delta) {
+  int k;
+
+  *delta = *now;
+  delta->callbacks -= before->callbacks;
+  delta->deadlineMisses -= before->deadlineMisses;
+  delta->underflows -= before->underflows;
+  delta->overflows -= before->overflows;
+  delta->totalNanoseconds -= before->totalNanoseconds;
+  for (k = 0; k < CALLBACKSTATS_BUCKETS; k++)
+    delta->histogram[k] -= before->histogram[k];
+}
+
+void callbackStatsPrint(FILE *file, const callbackstatsSnapshot *snapshot) {
+  const double deadlineNs = snapshot->deadline * 1e9;
+  double mean = 0.;
+  int k;
+
+  if (snapshot->callbacks > 0)
+    mean = (double)snapshot->totalNanoseconds / snapshot->callbacks;
+  fprintf(file,
+          "callbacks %llu, mean %.1f us (%.1f%% of deadline), max %.1f us, "
+          "missed %llu, underflows %llu, overflows %llu",
+          snapshot->callbacks, mean * 1e-3, 100. * mean / deadlineNs,
+          snapshot->maxNanoseconds * 1e-3, snapshot->deadlineMisses,
+          snapshot->underflows, snapshot->overflows);
+  if (snapshot->cpuLoad >= 0.)
+    fprintf(file, ", cpu load %.1f%%", 100. * snapshot->cpuLoad);
+  fprintf(file, "\n");
+
+  for (k = 0; k < CALLBACKSTATS_BUCKETS; k++) {
+    if (snapshot->histogram[k] == 0) continue;
+    fprintf(file, "  %10.1f - %10.1f us  %5.1f%% of deadline  %llu\n",
+            (1ull << k) * 1e-3, (2ull << k) * 1e-3,
+            100. * (1ull << k) / deadlineNs, snapshot->histogram[k]);
+  }
+}
+
+int timedCallback(const void *inputBuffer, void *outputBuffer,
+                  unsigned long framesPerBuffer,
+                  const PaStreamCallbackTimeInfo *timeInfo,
+                  PaStreamCallbackFlags statusFlags, void *userData) {
+  timedcallback *timed = (timedcallback *)userData;
+  unsigned long long start = callbackStatsNow();
+  int result = timed->callback(inputBuffer, outputBuffer, framesPerBuffer,
+                               timeInfo, statusFlags, timed->userData);
+
+  callbackStatsRecord(timed->stats, callbackStatsNow() - start, statusFlags);
+  return result;
+}
@@ -0,0 +1,81 @@
+/**
+ *  Purpose:
+ *    callback timing and CPU load instrumentation
+ *
+ *  callbackstats.h
+ *
+ *  The audio thread records how long every callback took against its
+ *  deadline (framesPerBuffer / sample rate), how many deadlines it missed
+ *  and which underflow/overflow statusFlags PortAudio reported. Durations
+ *  go into a histogram of power of two nanosecond buckets.
+ *
+ *  Recording only does relaxed atomic loads and stores on counters owned by
+ *  the audio thread: no locks, no allocation, no system calls apart from
+ *  reading the monotonic clock. Any other thread may take a snapshot at any
+ *  time and print it, adding Pa_GetStreamCpuLoad if a stream is running.
+ */
+
+#ifndef CALLBACKSTATS_H
+#define CALLBACKSTATS_H
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include "portaudio.h"
+
+#define CALLBACKSTATS_BUCKETS 32  // bucket k counts [2^k, 2^(k+1)) ns
+
+typedef struct {
+  double deadline;  // seconds available per callback
+  atomic_ullong callbacks;
+  atomic_ullong deadlineMisses;
+  atomic_ullong underflows;  // paInputUnderflow or paOutputUnderflow
+  atomic_ullong overflows;   // paInputOverflow or paOutputOverflow
+  atomic_ullong totalNanoseconds;
+  atomic_ullong maxNanoseconds;
+  atomic_ullong histogram[CALLBACKSTATS_BUCKETS];
+} callbackstats;
+
+// plain copy of the counters for the reporting thread
+typedef struct {
+  double deadline;
+  unsigned long long callbacks;
+  unsigned long long deadlineMisses;
+  unsigned long long underflows;
+  unsigned long long overflows;
+  unsigned long long totalNanoseconds;
+  unsigned long long maxNanoseconds;
+  unsigned long long histogram[CALLBACKSTATS_BUCKETS];
+  double cpuLoad;  // Pa_GetStreamCpuLoad, filled in by the caller (or -1)
+} callbackstatsSnapshot;
+
+// wraps a stream callback and times every call into stats
+typedef struct {
+  PaStreamCallback *callback;
+  void *userData;
+  callbackstats *stats;
+} timedcallback;
+
+void callbackStatsInit(callbackstats *stats, unsigned long framesPerBuffer,
+                       double sampleRate);
+// monotonic clock in nanoseconds
+unsigned long long callbackStatsNow(void);
+// audio thread only: account one callback that took nanoseconds
+void callbackStatsRecord(callbackstats *stats, unsigned long long nanoseconds,
+                         PaStreamCallbackFlags statusFlags);
+// any thread; cpuLoad is set to -1
+void callbackStatsSnapshot(callbackstats *stats,
+                           callbackstatsSnapshot *snapshot);
+// counts accumulated between two snapshots, for periodic reports;
+// maxNanoseconds stays the maximum since callbackStatsInit
+void callbackStatsDelta(const callbackstatsSnapshot *now,
+                        const callbackstatsSnapshot *before,
+                        callbackstatsSnapshot *delta);
+void callbackStatsPrint(FILE *file, const callbackstatsSnapshot *snapshot);
+
+// PaStreamCallback with userData a timedcallback *
+int timedCallback(const void *inputBuffer, void *outputBuffer,
+                  unsigned long framesPerBuffer,
+                  const PaStreamCallbackTimeInfo *timeInfo,
+                  PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // CALLBACKSTATS_H
@@ -0,0 +1,93 @@
+/**
+ *  Purpose:
+ *    small radix-2 complex FFT, see fft.h
+ *
+ *  fft.c
+ */
+
+#include "fft.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define TWOPI (6.283185307179586)
+
+int fftInit(fft *plan, int bits) {
+  unsigned long i, j, n = 1ul << bits;
+  int b;
+
+  plan->bits = bits;
+  plan->length = n;
+  plan->cosine = malloc(n / 2 * sizeof(double));
+  plan->sine = malloc(n / 2 * sizeof(double));
+  plan->reverse = malloc(n * sizeof(unsigned long));
+  if (plan->cosine == NULL || plan->sine == NULL || plan->reverse == NULL) {
+    fftFree(plan);
+    return -1;
+  }
+
+  for (i = 0; i < n / 2; i++) {
+    plan->cosine[i] = cos(TWOPI * i / n);
+    plan->sine[i] = sin(TWOPI * i / n);
+  }
+  for (i = 0; i < n; i++) {
+    for (j = 0, b = 0; b < bits; b++) j |= ((i >> b) & 1) << (bits - 1 - b);
+    plan->reverse[i] = j;
+  }
+
+  return 0;
+}
+
+void fftFree(fft *plan) {
+  free(plan->cosine);
+  free(plan->sine);
+  free(plan->reverse);
+  plan->cosine = plan->sine = NULL;
+  plan->reverse = NULL;
+}
+
+// sign is -1 for the forward and +1 for the inverse transform
+static void transform(const fft *plan, double *re, double *im, double sign) {
+  unsigned long n = plan->length, i, j, k, half, stride;
+  double wr, wi, tr, ti, t;
+
+  for (i = 0; i < n; i++) {
+    j = plan->reverse[i];
+    if (j > i) {
+      t = re[i], re[i] = re[j], re[j] = t;
+      t = im[i], im[i] = im[j], im[j] = t;
+    }
+  }
+
+  for (half = 1; half < n; half <<= 1) {
+    stride = n / (2 * half);  // twiddle step for this stage
+    for (i = 0; i < n; i += 2 * half) {
+      for (k = 0; k < half; k++) {
+        wr = plan->cosine[k * stride];
+        wi = sign * plan->sine[k * stride];
+        j = i + k + half;
+        tr = re[j] * wr - im[j] * wi;
+        ti = re[j] * wi + im[j] * wr;
+        re[j] = re[i + k] - tr;
+        im[j] = im[i + k] - ti;
+        re[i + k] += tr;
+        im[i + k] += ti;
+      }
+    }
+  }
+}
+
+void fftForward(const fft *plan, double *re, double *im) {
+  transform(plan, re, im, -1.);
+}
+
+void fftInverse(const fft *plan, double *re, double *im) {
+  unsigned long i;
+  const double scale = 1. / plan->length;
+
+  transform(plan, re, im, 1.);
+  for (i = 0; i < plan->length; i++) {
+    re[i] *= scale;
+    im[i] *= scale;
+  }
+}
@@ -0,0 +1,31 @@
+/**
+ *  Purpose:
+ *    small radix-2 complex FFT for building and analysing wavetables
+ *
+ *  fft.h
+ *
+ *  Iterative in-place transform on split real/imaginary double arrays with
+ *  a precomputed twiddle and bit reversal table. fftInit allocates, the
+ *  transforms themselves never do.
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+typedef struct {
+  int bits;
+  unsigned long length;    // 2^bits points
+  double *cosine;          // length / 2 twiddle factors
+  double *sine;
+  unsigned long *reverse;  // bit reversed index of every point
+} fft;
+
+// returns 0 on success
+int fftInit(fft *plan, int bits);
+void fftFree(fft *plan);
+// X[k] = sum x[n] e^(-2 pi i k n / N)
+void fftForward(const fft *plan, double *re, double *im);
+// x[n] = 1/N sum X[k] e^(2 pi i k n / N)
+void fftInverse(const fft *plan, double *re, double *im);
+
+#endif  // FFT_H
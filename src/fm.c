@@ -0,0 +1,318 @@
+/**
+ *  Purpose:
+ *    phase modulation synth, see fm.h
+ *
+ *  fm.c
+ */
+
+#include "fm.h"
+
+#include <limits.h>
+#include <string.h>
+#include "phasor.h"
+
+#define FM_PHASE_PER_RADIAN (683565275.6f)  // 2^32 / 2pi
+#define OP(n) (1u << ((n) - 1))             // bit of operator n, 1 to 6
+
+static const struct {
+  const char *name;
+  uint8_t modulators[FM_OPERATORS];
+  uint8_t carriers;
+} algorithms[FM_ALGO_COUNT] = {
+    {"stack", {OP(2), OP(3), OP(4), OP(5), OP(6), 0}, OP(1)},
+    {"twostacks", {OP(2), OP(3), 0, OP(5), OP(6), 0}, OP(1) | OP(4)},
+    {"pairstack", {OP(2), 0, OP(4), OP(5), OP(6), 0}, OP(1) | OP(3)},
+    {"threepairs", {OP(2), 0, OP(4), 0, OP(6), 0}, OP(1) | OP(3) | OP(5)},
+    {"branch", {OP(2) | OP(3) | OP(4) | OP(5) | OP(6), 0, 0, 0, 0, 0}, OP(1)},
+    {"fan", {OP(2), 0, OP(6), OP(6), OP(6), 0},
+     OP(1) | OP(3) | OP(4) | OP(5)},
+    {"organ", {0, 0, 0, 0, 0, 0}, 0x3f},
+};
+
+void fmPatchInit(fmpatch *patch, fmalgorithm algorithm) {
+  int op, carriers = 0;
+
+  memset(patch, 0, sizeof(*patch));
+  if (algorithm < 0 || algorithm >= FM_ALGO_COUNT) algorithm = FM_ALGO_STACK;
+  memcpy(patch->modulators, algorithms[algorithm].modulators,
+         sizeof(patch->modulators));
+  patch->carriers = algorithms[algorithm].carriers;
+  patch->feedbackOperator = FM_OPERATORS - 1;  // op 6 in every preset
+  for (op = 0; op < FM_OPERATORS; op++)
+    if (patch->carriers & (1u << op)) carriers++;
+  for (op = 0; op < FM_OPERATORS; op++) {
+    patch->ratio[op] = 1.f;
+    patch->level[op] = patch->carriers & (1u << op) ? 1.f / carriers : 1.f;
+  }
+}
+
+const char *fmAlgorithmName(fmalgorithm algorithm) {
+  return algorithm >= 0 && algorithm < FM_ALGO_COUNT
+             ? algorithms[algorithm].name
+             : "unknown";
+}
+
+fmalgorithm fmAlgorithmParse(const char *name) {
+  int a;
+
+  for (a = 0; a < FM_ALGO_COUNT; a++)
+    if (strcmp(name, algorithms[a].name) == 0) return (fmalgorithm)a;
+  return FM_ALGO_COUNT;
+}
+
+void fmInit(fmsynth *fm, const float *wavetable, int tableBits,
+            double sampleRate, int maxVoices) {
+  fmpatch patch;
+
+  memset(fm, 0, sizeof(*fm));
+  if (maxVoices < 1 || maxVoices > FM_MAX_VOICES) maxVoices = FM_MAX_VOICES;
+  fm->maxVoices = maxVoices;
+  fm->wavetable = wavetable;
+  fm->tableBits = tableBits;
+  fm->sampleRate = sampleRate;
+  fm->gain = 1.f;
+  fm->releaseFrames = (unsigned long)(FM_RELEASE_SECONDS * sampleRate + .5);
+  if (fm->releaseFrames == 0) fm->releaseFrames = 1;
+  fmPatchInit(&patch, FM_ALGO_STACK);
+  fmSetPatch(fm, &patch);
+}
+
+static void setIncrements(fmsynth *fm, int v) {
+  int op;
+
+  for (op = 0; op < FM_OPERATORS; op++)
+    fm->increment[op][v] = phasorIncrement(
+        fm->frequency[v] * fm->patch.ratio[op], fm->sampleRate);
+}
+
+int fmSetPatch(fmsynth *fm, const fmpatch *patch) {
+  int op, v;
+
+  // operator op may only be modulated by operators above it
+  for (op = 0; op < FM_OPERATORS; op++)
+    if (patch->modulators[op] & ~(0x3fu & ~((2u << op) - 1))) return -1;
+  if (patch->feedbackOperator >= FM_OPERATORS) return -1;
+
+  fm->patch = *patch;
+  for (v = 0; v < fm->activeCount; v++) setIncrements(fm, v);
+  return 0;
+}
+
+// move the last active voice into slot v, keeping the arrays dense
+static void removeVoice(fmsynth *fm, int v) {
+  int last = --fm->activeCount;
+  int op;
+
+  for (op = 0; op < FM_OPERATORS; op++) {
+    fm->phase[op][v] = fm->phase[op][last];
+    fm->increment[op][v] = fm->increment[op][last];
+  }
+  fm->frequency[v] = fm->frequency[last];
+  fm->amplitude[v] = fm->amplitude[last];
+  fm->ampStep[v] = fm->ampStep[last];
+  fm->releaseLeft[v] = fm->releaseLeft[last];
+  fm->history[v][0] = fm->history[last][0];
+  fm->history[v][1] = fm->history[last][1];
+  fm->started[v] = fm->started[last];
+  fm->id[v] = fm->id[last];
+  fm->key[v] = fm->key[last];
+}
+
+int fmNoteOn(fmsynth *fm, int key, float frequency, float amplitude) {
+  int v, steal, op;
+
+  if (fm->activeCount < fm->maxVoices) {
+    v = fm->activeCount++;
+  } else {
+    // steal the voice closest to the end of its release, or if none is
+    // releasing the one that has been playing longest
+    steal = 0;
+    for (v = 1; v < fm->activeCount; v++)
+      if (fm->releaseLeft[v] != fm->releaseLeft[steal]
+              ? fm->releaseLeft[v] < fm->releaseLeft[steal]
+              : fm->started[v] < fm->started[steal])
+        steal = v;
+    v = steal;
+  }
+
+  fm->frequency[v] = frequency;
+  fm->amplitude[v] = amplitude;
+  fm->ampStep[v] = 0.f;
+  fm->releaseLeft[v] = FM_HELD;
+  for (op = 0; op < FM_OPERATORS; op++) fm->phase[op][v] = 0;
+  setIncrements(fm, v);
+  fm->history[v][0] = fm->history[v][1] = 0.f;
+  fm->started[v] = fm->notes;
+  fm->id[v] = (int)(fm->notes & INT_MAX);
+  fm->key[v] = key;
+  fm->notes++;
+
+  return fm->id[v];
+}
+
+void fmNoteOff(fmsynth *fm, int key) {
+  int v;
+
+  if (key < 0) return;  // voices started without a key
+  // start the fade out of the held voices, once
+  for (v = 0; v < fm->activeCount; v++)
+    if (fm->key[v] == key && fm->releaseLeft[v] == FM_HELD) {
+      fm->releaseLeft[v] = fm->releaseFrames;
+      fm->ampStep[v] = -fm->amplitude[v] / fm->releaseFrames;
+    }
+}
+
+// one operator over a chunk: level * sin(phase + modulation[i]), with the
+// modulation in radians, or the plain oscillator when it is NULL
+static void renderOperator(const float *table, int bits, uint32_t *phase,
+                           uint32_t increment, float level,
+                           const float *modulation, float *out,
+                           unsigned long frames) {
+  uint32_t p = *phase, q, index;
+  unsigned long i;
+  float f, y0;
+
+  if (modulation == NULL) {
+    for (i = 0; i < frames; i++) {
+      index = phasorIndex(p, bits);
+      f = phasorFraction(p, bits);
+      y0 = table[index];
+      out[i] = level * (y0 + f * (table[index + 1] - y0));
+      p += increment;
+    }
+  } else {
+    for (i = 0; i < frames; i++) {
+      q = p + (uint32_t)(int64_t)(modulation[i] * FM_PHASE_PER_RADIAN);
+      index = phasorIndex(q, bits);
+      f = phasorFraction(q, bits);
+      y0 = table[index];
+      out[i] = level * (y0 + f * (table[index + 1] - y0));
+      p += increment;
+    }
+  }
+  *phase = p;
+}
+
+// the same for the feedback operator, whose phase is also shifted by the
+// mean of its last two outputs (as the DX7, which keeps it from ringing);
+// the recursion makes this loop sample by sample
+static void renderFeedback(const float *table, int bits, uint32_t *phase,
+                           uint32_t increment, float level, float feedback,
+                           float *history, const float *modulation,
+                           float *out, unsigned long frames) {
+  uint32_t p = *phase, q, index;
+  unsigned long i;
+  float f, y0, y, m, h0 = history[0], h1 = history[1];
+
+  for (i = 0; i < frames; i++) {
+    m = feedback * .5f * (h0 + h1);
+    if (modulation != NULL) m += modulation[i];
+    q = p + (uint32_t)(int64_t)(m * FM_PHASE_PER_RADIAN);
+    index = phasorIndex(q, bits);
+    f = phasorFraction(q, bits);
+    y0 = table[index];
+    y = y0 + f * (table[index + 1] - y0);
+    h1 = h0;
+    h0 = y;
+    out[i] = level * y;
+    p += increment;
+  }
+  history[0] = h0;
+  history[1] = h1;
+  *phase = p;
+}
+
+// the operators of voice v into fm->buffer, the last operator first
+static void renderVoice(fmsynth *fm, int v, unsigned long frames) {
+  const fmpatch *patch = &fm->patch;
+  const float *modulation;
+  unsigned long i;
+  unsigned mods;
+  int op, m;
+
+  for (op = FM_OPERATORS - 1; op >= 0; op--) {
+    mods = patch->modulators[op];
+    modulation = NULL;
+    if (mods != 0 && (mods & (mods - 1)) == 0) {
+      // a single modulator is read straight from its buffer
+      modulation = fm->buffer[__builtin_ctz(mods)];
+    } else if (mods != 0) {
+      memset(fm->modulation, 0, frames * sizeof(float));
+      for (m = op + 1; m < FM_OPERATORS; m++)
+        if (mods & (1u << m))
+          for (i = 0; i < frames; i++) fm->modulation[i] += fm->buffer[m][i];
+      modulation = fm->modulation;
+    }
+
+    if (op == patch->feedbackOperator && patch->feedback != 0.f)
+      renderFeedback(fm->wavetable, fm->tableBits, &fm->phase[op][v],
+                     fm->increment[op][v], patch->level[op], patch->feedback,
+                     fm->history[v], modulation, fm->buffer[op], frames);
+    else
+      renderOperator(fm->wavetable, fm->tableBits, &fm->phase[op][v],
+                     fm->increment[op][v], patch->level[op], modulation,
+                     fm->buffer[op], frames);
+  }
+}
+
+void fmRender(fmsynth *fm, float *out, unsigned long frames) {
+  unsigned long i, n, m;
+  float amp, step;
+  int v, op;
+
+  while (frames > 0) {
+    n = frames < FM_CHUNK ? frames : FM_CHUNK;
+    memset(fm->mix, 0, n * sizeof(float));
+
+    for (v = 0; v < fm->activeCount; v++) {
+      renderVoice(fm, v, n);
+      amp = fm->amplitude[v];
+      step = fm->ampStep[v];
+      if (fm->releaseLeft[v] == FM_HELD) {
+        for (op = 0; op < FM_OPERATORS; op++)
+          if (fm->patch.carriers & (1u << op))
+            for (i = 0; i < n; i++) fm->mix[i] += amp * fm->buffer[op][i];
+      } else {
+        // releasing: the carrier gain of sample i in closed form, up to
+        // the end of the ramp, silent after it
+        m = n < fm->releaseLeft[v] ? n : fm->releaseLeft[v];
+        for (op = 0; op < FM_OPERATORS; op++)
+          if (fm->patch.carriers & (1u << op))
+            for (i = 0; i < m; i++)
+              fm->mix[i] += (amp + (float)i * step) * fm->buffer[op][i];
+        fm->amplitude[v] = amp + (float)m * step;
+        fm->releaseLeft[v] -= m;
+      }
+    }
+
+    for (i = 0; i < n; i++) {
+      *out++ = fm->gain * fm->mix[i];  // left channel
+      *out++ = fm->gain * fm->mix[i];  // right channel
+    }
+    frames -= n;
+
+    // free the voices that have faded out
+    for (v = 0; v < fm->activeCount;)
+      if (fm->releaseLeft[v] == 0)
+        removeVoice(fm, v);
+      else
+        v++;
+  }
+}
+
+void fmEventHandler(const event *e, void *userData) {
+  fmsynth *fm = (fmsynth *)userData;
+
+  if (e->type == EVENT_NOTE_ON)
+    fmNoteOn(fm, e->key, e->value, e->amplitude);
+  else if (e->type == EVENT_NOTE_OFF)
+    fmNoteOff(fm, e->key);
+}
+
+int fmCallback(const void *inputBuffer, void *outputBuffer,
+               unsigned long framesPerBuffer,
+               const PaStreamCallbackTimeInfo *timeInfo,
+               PaStreamCallbackFlags statusFlags, void *userData) {
+  fmRender((fmsynth *)userData, (float *)outputBuffer, framesPerBuffer);
+  return paContinue;
+}
@@ -0,0 +1,115 @@
+/**
+ *  Purpose:
+ *    polyphonic phase modulation (FM) synth of six wavetable operators
+ *
+ *  fm.h
+ *
+ *  Every voice runs FM_OPERATORS phasor oscillators reading the sine table
+ *  with the linear interpolation of wavetable2.c. An operator's output
+ *  shifts the phase of the operators it modulates (phase modulation, as
+ *  the DX7 does it); the outputs of the carriers are the sound. Which
+ *  operator modulates which is the algorithm: a modulation matrix where
+ *  operator i may only be modulated by higher operators, so rendering
+ *  from the last operator down to the first is always in order. One
+ *  operator may feed back into its own phase.
+ *
+ *  The voice state is a structure of arrays per operator, like the voice
+ *  pool's. A voice is rendered FM_CHUNK frames at a time, one operator
+ *  after the other through per operator output buffers, so each operator
+ *  loop keeps its phase in a register and modulation is a buffer read.
+ *  All storage is inside the struct; notes never allocate.
+ */
+
+#ifndef FM_H
+#define FM_H
+
+#include <limits.h>
+#include <stdint.h>
+#include "portaudio.h"
+#include "scheduler.h"
+
+#define FM_OPERATORS 6
+#define FM_MAX_VOICES 128
+#define FM_CHUNK 64  // frames per operator buffer
+#define FM_RELEASE_SECONDS (0.005)  // fade out after a note off
+#define FM_HELD ULONG_MAX           // releaseLeft until the note off
+
+// preset algorithms, op 1 to 6 are operators 0 to 5
+typedef enum {
+  FM_ALGO_STACK,        // 6 > 5 > 4 > 3 > 2 > 1
+  FM_ALGO_TWO_STACKS,   // 3 > 2 > 1 and 6 > 5 > 4 (DX7 algorithm 3)
+  FM_ALGO_PAIR_STACK,   // 2 > 1 and 6 > 5 > 4 > 3 (DX7 algorithm 1)
+  FM_ALGO_THREE_PAIRS,  // 2 > 1, 4 > 3 and 6 > 5 (DX7 algorithm 5)
+  FM_ALGO_BRANCH,       // 2 to 6 all modulate 1
+  FM_ALGO_FAN,          // 2 > 1 and 6 > 3, 4, 5 (DX7 algorithm 22)
+  FM_ALGO_ORGAN,        // six carriers, 6 feeds back (DX7 algorithm 32)
+  FM_ALGO_COUNT
+} fmalgorithm;
+
+typedef struct {
+  uint8_t modulators[FM_OPERATORS];  // bit m set: operator m modulates
+  uint8_t carriers;                  // bit i set: operator i is heard
+  int feedbackOperator;              // -1 for none
+  float ratio[FM_OPERATORS];         // frequency as a multiple of the note
+  float level[FM_OPERATORS];  // carrier gain, or modulation index (radians)
+  float feedback;             // index of the feedback path, radians
+} fmpatch;
+
+typedef struct {
+  // per operator and voice, slots [0, activeCount) are playing
+  uint32_t phase[FM_OPERATORS][FM_MAX_VOICES];
+  uint32_t increment[FM_OPERATORS][FM_MAX_VOICES];
+  float frequency[FM_MAX_VOICES];
+  float amplitude[FM_MAX_VOICES];
+  float ampStep[FM_MAX_VOICES];              // per sample, 0 while held
+  unsigned long releaseLeft[FM_MAX_VOICES];  // frames until freed
+  float history[FM_MAX_VOICES][2];  // last outputs of the feedback operator
+  unsigned long started[FM_MAX_VOICES];  // note counter at noteOn
+  int id[FM_MAX_VOICES];                 // handle given to the caller
+  int key[FM_MAX_VOICES];                // caller's note key, or -1
+  int activeCount;
+  int maxVoices;
+
+  fmpatch patch;
+  const float *wavetable;  // sine, 2^tableBits points plus a guard point
+  int tableBits;
+  double sampleRate;
+  float gain;            // applied to the mix
+  unsigned long releaseFrames;  // length of the release ramp
+  unsigned long notes;   // notes started so far, also the next id
+
+  float buffer[FM_OPERATORS][FM_CHUNK];  // operator outputs of one voice
+  float modulation[FM_CHUNK];            // summed modulators of one operator
+  float mix[FM_CHUNK];
+} fmsynth;
+
+// the routing of a preset algorithm with every ratio 1, carriers at full
+// level shared between them and modulators at index 1
+void fmPatchInit(fmpatch *patch, fmalgorithm algorithm);
+const char *fmAlgorithmName(fmalgorithm algorithm);
+// name as printed by fmAlgorithmName, or FM_ALGO_COUNT if unknown
+fmalgorithm fmAlgorithmParse(const char *name);
+
+void fmInit(fmsynth *fm, const float *wavetable, int tableBits,
+            double sampleRate, int maxVoices);
+// 0, or -1 if an operator is modulated by itself or a lower operator
+int fmSetPatch(fmsynth *fm, const fmpatch *patch);
+// returns a handle for the new voice, stealing a releasing voice or else
+// the oldest when full
+int fmNoteOn(fmsynth *fm, int key, float frequency, float amplitude);
+// releases every voice still holding key, freed once they have faded out
+void fmNoteOff(fmsynth *fm, int key);
+// sum of all active voices as interleaved stereo, overwrites out
+void fmRender(fmsynth *fm, float *out, unsigned long frames);
+
+// eventHandler for a scheduler driving fmCallback: notes by key, parameter
+// events are ignored
+void fmEventHandler(const event *e, void *userData);
+
+// PaStreamCallback rendering the fmsynth passed as userData
+int fmCallback(const void *inputBuffer, void *outputBuffer,
+               unsigned long framesPerBuffer,
+               const PaStreamCallbackTimeInfo *timeInfo,
+               PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // FM_H
@@ -0,0 +1,294 @@
+/**
+ *  Purpose:
+ *    processing graph, see graph.h
+ *
+ *  graph.c
+ */
+
+#include "graph.h"
+
+#include <math.h>
+#include <string.h>
+
+#define TWOPI (6.283185307179586)
+
+void graphInit(graph *g, double sampleRate) {
+  memset(g, 0, sizeof(*g));
+  g->output = -1;
+  g->sampleRate = sampleRate;
+  g->status = paContinue;
+}
+
+static int addNode(graph *g, graphnodetype type) {
+  graphnode *node;
+
+  if (g->nodeCount == GRAPH_MAX_NODES) return -1;
+  node = &g->nodes[g->nodeCount];
+  memset(node, 0, sizeof(*node));
+  node->type = type;
+  return g->nodeCount++;
+}
+
+int graphAddSource(graph *g, PaStreamCallback *callback, void *userData) {
+  int n = addNode(g, GRAPH_SOURCE);
+
+  if (n < 0) return -1;
+  g->nodes[n].callback = callback;
+  g->nodes[n].userData = userData;
+  return n;
+}
+
+int graphAddFilter(graph *g, filtertype type, double frequency, double q) {
+  int n = addNode(g, GRAPH_FILTER);
+
+  if (n < 0) return -1;
+  graphSetFilter(g, n, type, frequency, q);
+  return n;
+}
+
+int graphAddMixer(graph *g) { return addNode(g, GRAPH_MIXER); }
+
+int graphAddSink(graph *g, nullDeviceSink sink, void *sinkData) {
+  int n = addNode(g, GRAPH_SINK);
+
+  if (n < 0) return -1;
+  g->nodes[n].sink = sink;
+  g->nodes[n].sinkData = sinkData;
+  return n;
+}
+
+// inputs a node of each type takes
+static int maxInputs(graphnodetype type) {
+  switch (type) {
+    case GRAPH_SOURCE:
+      return 0;
+    case GRAPH_MIXER:
+      return GRAPH_MAX_INPUTS;
+    default:
+      return 1;
+  }
+}
+
+int graphConnect(graph *g, int from, int to, float gain) {
+  graphnode *node;
+
+  if (from < 0 || from >= g->nodeCount || to < 0 || to >= g->nodeCount ||
+      g->nodes[from].type == GRAPH_SINK)
+    return -1;
+  node = &g->nodes[to];
+  if (node->inputCount == maxInputs(node->type)) return -1;
+  node->inputs[node->inputCount] = from;
+  node->gain[node->inputCount] = gain;
+  node->inputCount++;
+  return 0;
+}
+
+void graphSetOutput(graph *g, int node) { g->output = node; }
+
+// RBJ audio EQ cookbook
+void graphSetFilter(graph *g, int node, filtertype type, double frequency,
+                    double q) {
+  graphnode *f = &g->nodes[node];
+  double w = TWOPI * frequency / g->sampleRate;
+  double c = cos(w), alpha = sin(w) / (2. * q);
+  double a0 = 1. + alpha, b0, b1, b2;
+
+  switch (type) {
+    case FILTER_HIGHPASS:
+      b0 = b2 = .5 * (1. + c);
+      b1 = -(1. + c);
+      break;
+    case FILTER_BANDPASS:  // 0 dB at the centre
+      b0 = alpha;
+      b1 = 0.;
+      b2 = -alpha;
+      break;
+    default:
+      b0 = b2 = .5 * (1. - c);
+      b1 = 1. - c;
+      break;
+  }
+  f->b0 = (float)(b0 / a0);
+  f->b1 = (float)(b1 / a0);
+  f->b2 = (float)(b2 / a0);
+  f->a1 = (float)(-2. * c / a0);
+  f->a2 = (float)((1. - alpha) / a0);
+}
+
+static void processSource(graph *g, const graphstep *step,
+                          unsigned long frames) {
+  const graphnode *node = step->node;
+  int r = node->callback(NULL, step->out, frames, &g->time, g->flags,
+                         node->userData);
+
+  if (g->status == paContinue) g->status = r;
+}
+
+// sample by sample, so out may be in[0]
+static void processFilter(graph *g, const graphstep *step,
+                          unsigned long frames) {
+  graphnode *f = step->node;
+  const float *in = step->in[0];
+  float *out = step->out;
+  float x, y, z1, z2;
+  unsigned long i;
+  int c;
+
+  for (c = 0; c < GRAPH_CHANNELS; c++) {
+    z1 = f->z1[c];
+    z2 = f->z2[c];
+    for (i = c; i < frames * GRAPH_CHANNELS; i += GRAPH_CHANNELS) {
+      x = in[i];
+      y = f->b0 * x + z1;
+      z1 = f->b1 * x - f->a1 * y + z2;
+      z2 = f->b2 * x - f->a2 * y;
+      out[i] = y;
+    }
+    f->z1[c] = z1;
+    f->z2[c] = z2;
+  }
+}
+
+// the first input is read before out is written, so out may be in[0]
+static void processMixer(graph *g, const graphstep *step,
+                         unsigned long frames) {
+  const graphnode *node = step->node;
+  const unsigned long n = frames * GRAPH_CHANNELS;
+  const float *in;
+  float *out = step->out;
+  float gain = node->gain[0];
+  unsigned long i;
+  int k;
+
+  for (i = 0; i < n; i++) out[i] = gain * step->in[0][i];
+  for (k = 1; k < node->inputCount; k++) {
+    in = step->in[k];
+    gain = node->gain[k];
+    for (i = 0; i < n; i++) out[i] += gain * in[i];
+  }
+}
+
+static void processSink(graph *g, const graphstep *step,
+                        unsigned long frames) {
+  const graphnode *node = step->node;
+
+  if (node->sink(step->in[0], frames, GRAPH_CHANNELS, node->sinkData) != 0 &&
+      g->status == paContinue)
+    g->status = paAbort;
+}
+
+int graphCompile(graph *g) {
+  static const graphprocess process[] = {processSource, processFilter,
+                                         processMixer, processSink};
+  int needed[GRAPH_MAX_NODES] = {0}, placed[GRAPH_MAX_NODES] = {0};
+  int order[GRAPH_MAX_NODES], lastUse[GRAPH_MAX_NODES], slot[GRAPH_MAX_NODES];
+  int stack[GRAPH_MAX_NODES], freeSlots[GRAPH_MAX_NODES];
+  int depth = 0, freeCount = 0, count = 0, n, k, p, in, ready;
+  graphnode *node;
+  graphstep *step;
+
+  g->stepCount = g->bufferCount = 0;
+  if (g->output < 0 || g->output >= g->nodeCount ||
+      g->nodes[g->output].type == GRAPH_SINK)
+    return -1;
+
+  // only what feeds the output or a sink is rendered
+  for (n = 0; n < g->nodeCount; n++)
+    if (n == g->output || g->nodes[n].type == GRAPH_SINK) {
+      needed[n] = 1;
+      stack[depth++] = n;
+    }
+  while (depth > 0) {
+    node = &g->nodes[stack[--depth]];
+    if (node->inputCount == 0 && node->type != GRAPH_SOURCE) return -1;
+    for (k = 0; k < node->inputCount; k++)
+      if (!needed[node->inputs[k]]) {
+        needed[node->inputs[k]] = 1;
+        stack[depth++] = node->inputs[k];
+      }
+  }
+  for (n = 0; n < g->nodeCount; n++) count += needed[n];
+
+  // topological order, the lowest ready node first so it is repeatable;
+  // quadratic, but only done once
+  for (p = 0; p < count; p++) {
+    for (n = 0; n < g->nodeCount; n++) {
+      if (!needed[n] || placed[n]) continue;
+      ready = 1;
+      for (k = 0; k < g->nodes[n].inputCount; k++)
+        if (!placed[g->nodes[n].inputs[k]]) ready = 0;
+      if (ready) break;
+    }
+    if (n == g->nodeCount) return -1;  // the rest is a cycle
+    placed[n] = 1;
+    order[p] = n;
+  }
+
+  // a buffer is live until the last step that reads it, the output's to
+  // the end of the block
+  for (p = 0; p < count; p++) {
+    node = &g->nodes[order[p]];
+    for (k = 0; k < node->inputCount; k++) lastUse[node->inputs[k]] = p;
+  }
+  lastUse[g->output] = count;
+
+  for (p = 0; p < count; p++) {
+    n = order[p];
+    node = &g->nodes[n];
+    step = &g->steps[p];
+    step->process = process[node->type];
+    step->node = node;
+    for (k = 0; k < node->inputCount; k++)
+      step->in[k] = g->buffer[slot[node->inputs[k]]];
+
+    // the first input may be overwritten if nothing else reads it
+    in = node->inputCount > 0 ? node->inputs[0] : -1;
+    for (k = 1; k < node->inputCount && in >= 0; k++)
+      if (node->inputs[k] == in) in = -1;
+    if (in >= 0 && lastUse[in] == p && node->type != GRAPH_SINK) {
+      freeSlots[freeCount++] = slot[in];
+      lastUse[in] = -1;  // freed
+    }
+    if (node->type != GRAPH_SINK) {
+      slot[n] = freeCount > 0 ? freeSlots[--freeCount] : g->bufferCount++;
+      step->out = g->buffer[slot[n]];
+    } else {
+      step->out = NULL;
+    }
+    for (k = 0; k < node->inputCount; k++) {
+      in = node->inputs[k];
+      if (lastUse[in] != p) continue;
+      freeSlots[freeCount++] = slot[in];
+      lastUse[in] = -1;
+    }
+  }
+
+  g->stepCount = count;
+  g->result = g->buffer[slot[g->output]];
+  return 0;
+}
+
+int graphCallback(const void *inputBuffer, void *outputBuffer,
+                  unsigned long framesPerBuffer,
+                  const PaStreamCallbackTimeInfo *timeInfo,
+                  PaStreamCallbackFlags statusFlags, void *userData) {
+  graph *g = (graph *)userData;
+  float *out = (float *)outputBuffer;
+  unsigned long done = 0, n;
+  int s;
+
+  g->time = *timeInfo;
+  g->flags = statusFlags;
+  while (done < framesPerBuffer) {
+    n = framesPerBuffer - done;
+    if (n > GRAPH_BLOCK) n = GRAPH_BLOCK;
+    g->time.outputBufferDacTime =
+        timeInfo->outputBufferDacTime + done / g->sampleRate;
+    for (s = 0; s < g->stepCount; s++)
+      g->steps[s].process(g, &g->steps[s], n);
+    memcpy(out + done * GRAPH_CHANNELS, g->result,
+           n * GRAPH_CHANNELS * sizeof(float));
+    done += n;
+  }
+  return g->status;
+}
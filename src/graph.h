@@ -0,0 +1,118 @@
+/**
+ *  Purpose:
+ *    processing graph of sources, filters, mixers and sinks behind one
+ *    stream callback
+ *
+ *  graph.h
+ *
+ *  Nodes are added and connected while nothing plays, then graphCompile
+ *  turns the graph into a flat schedule once: the nodes that reach the
+ *  output or a sink, in topological order, each step with its process
+ *  function and the buffers it reads and writes already resolved. Per
+ *  block graphCallback only walks that array.
+ *
+ *  Every node writes GRAPH_BLOCK frames of interleaved stereo into a
+ *  buffer, which is free again after the last step that reads it; the
+ *  compiler hands freed buffers out last in, first out, so the few that
+ *  are needed stay in cache. A step may write over the buffer of its first
+ *  input, which nodes process sample by sample allow. All buffers and the
+ *  schedule live in the struct, nothing is allocated.
+ *
+ *  Sources are any stream callback (an engine, or a scheduler in front of
+ *  one), filters are RBJ biquads, mixers sum their inputs with a gain per
+ *  connection, sinks hand their input to a nullDeviceSink (wavWriterSink
+ *  records it). The output node's buffer goes to the stream.
+ */
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include "nulldevice.h"
+#include "portaudio.h"
+
+#define GRAPH_MAX_NODES 64
+#define GRAPH_MAX_INPUTS 8
+#define GRAPH_BLOCK 256  // frames per step
+#define GRAPH_CHANNELS 2
+
+typedef enum {
+  GRAPH_SOURCE,
+  GRAPH_FILTER,
+  GRAPH_MIXER,
+  GRAPH_SINK  // no output, its input goes to the sink function
+} graphnodetype;
+
+typedef enum { FILTER_LOWPASS, FILTER_HIGHPASS, FILTER_BANDPASS } filtertype;
+
+typedef struct {
+  graphnodetype type;
+  int inputs[GRAPH_MAX_INPUTS];  // nodes, in order of connection
+  float gain[GRAPH_MAX_INPUTS];  // per input, applied by mixers
+  int inputCount;
+
+  // GRAPH_SOURCE
+  PaStreamCallback *callback;
+  void *userData;
+  // GRAPH_FILTER, direct form 2 transposed, state per channel
+  float b0, b1, b2, a1, a2;
+  float z1[GRAPH_CHANNELS], z2[GRAPH_CHANNELS];
+  // GRAPH_SINK
+  nullDeviceSink sink;
+  void *sinkData;
+} graphnode;
+
+typedef struct graph graph;
+typedef struct graphstep graphstep;
+typedef void (*graphprocess)(graph *g, const graphstep *step,
+                             unsigned long frames);
+
+// one node of the compiled schedule
+struct graphstep {
+  graphprocess process;
+  graphnode *node;
+  const float *in[GRAPH_MAX_INPUTS];
+  float *out;  // NULL for sinks
+};
+
+struct graph {
+  graphnode nodes[GRAPH_MAX_NODES];
+  int nodeCount;
+  int output;  // node played by the stream
+  double sampleRate;
+
+  // compiled
+  graphstep steps[GRAPH_MAX_NODES];
+  int stepCount;
+  int bufferCount;      // distinct buffers the schedule uses
+  const float *result;  // the output node's buffer
+
+  // of the piece being rendered, for the sources
+  PaStreamCallbackTimeInfo time;
+  PaStreamCallbackFlags flags;
+  int status;  // paContinue until a source or sink says otherwise
+  float buffer[GRAPH_MAX_NODES][GRAPH_CHANNELS * GRAPH_BLOCK];
+};
+
+void graphInit(graph *g, double sampleRate);
+// each returns the new node, or -1 when the graph is full
+int graphAddSource(graph *g, PaStreamCallback *callback, void *userData);
+int graphAddFilter(graph *g, filtertype type, double frequency, double q);
+int graphAddMixer(graph *g);
+int graphAddSink(graph *g, nullDeviceSink sink, void *sinkData);
+// feed from into to, -1 if to takes no (more) inputs
+int graphConnect(graph *g, int from, int to, float gain);
+void graphSetOutput(graph *g, int node);
+// recomputes a filter's coefficients, keeping its state
+void graphSetFilter(graph *g, int node, filtertype type, double frequency,
+                    double q);
+// builds the schedule, -1 for a cycle, a node without its inputs or no
+// output
+int graphCompile(graph *g);
+
+// PaStreamCallback rendering the compiled graph passed as userData
+int graphCallback(const void *inputBuffer, void *outputBuffer,
+                  unsigned long framesPerBuffer,
+                  const PaStreamCallbackTimeInfo *timeInfo,
+                  PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // GRAPH_H
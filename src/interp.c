@@ -0,0 +1,59 @@
+/**
+ *  Purpose:
+ *    table interpolation support, see interp.h
+ *
+ *  interp.c
+ */
+
+#include "interp.h"
+
+#include <math.h>
+#include <string.h>
+
+#define PI (3.141592653589793)
+
+float sincTable[SINC_PHASES + 1][SINC_TAPS];
+
+static const char *names[INTERP_COUNT] = {"truncate", "linear", "hermite",
+                                          "lagrange", "sinc"};
+
+void interpInit(void) {
+  static int done = 0;
+  const double half = SINC_TAPS / 2;
+  double x, w, sum, taps[SINC_TAPS];
+  int p, k;
+
+  if (done) return;
+  done = 1;
+  for (p = 0; p <= SINC_PHASES; p++) {
+    sum = 0.;
+    for (k = 0; k < SINC_TAPS; k++) {
+      // distance from the wanted position to tap k (points -3 .. 4)
+      x = (k - half + 1) - (double)p / SINC_PHASES;
+      w = .42 + .5 * cos(PI * x / half) + .08 * cos(2. * PI * x / half);
+      taps[k] = (x == 0. ? 1. : sin(PI * x) / (PI * x)) * w;
+      sum += taps[k];
+    }
+    // unity gain at DC for every fractional position
+    for (k = 0; k < SINC_TAPS; k++) sincTable[p][k] = taps[k] / sum;
+  }
+}
+
+const char *interpolationName(interpolation interp) {
+  return interp >= 0 && interp < INTERP_COUNT ? names[interp] : "unknown";
+}
+
+interpolation interpolationParse(const char *name) {
+  int i;
+
+  for (i = 0; i < INTERP_COUNT; i++)
+    if (strcmp(name, names[i]) == 0) return (interpolation)i;
+  return INTERP_COUNT;
+}
+
+void wavetableGuard(float *table, unsigned long length) {
+  int k;
+
+  for (k = 1; k <= WAVETABLE_GUARD; k++) table[-k] = table[length - k];
+  for (k = 0; k < WAVETABLE_GUARD; k++) table[length + k] = table[k];
+}
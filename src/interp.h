@@ -0,0 +1,96 @@
+/**
+ *  Purpose:
+ *    table interpolation kernels, from truncation up to windowed sinc
+ *
+ *  interp.h
+ *
+ *  Each kernel reads the points around table[index] and returns the value
+ *  at index + f, 0 <= f < 1. Higher orders cost more per voice but lower
+ *  the distortion (THD) of the reconstructed waveform:
+ *
+ *    truncate   1 point      table[index], as in wavetable1.c
+ *    linear     2 points     as in wavetable2.c
+ *    hermite    4 points     cubic Hermite (Catmull-Rom) spline
+ *    lagrange   4 points     third order Lagrange polynomial
+ *    sinc       8 points     Blackman windowed sinc, polyphase table
+ *
+ *  The kernels are static inline so a render loop written for one kernel
+ *  compiles to a loop with that kernel inlined; see wavetable.c. Tables
+ *  need WAVETABLE_GUARD wrapped points before and after the cycle, which
+ *  filltable and wavetableGuard provide.
+ */
+
+#ifndef INTERP_H
+#define INTERP_H
+
+#define WAVETABLE_GUARD 4     // guard points on each side of a table
+#define SINC_TAPS 8           // points -3 .. 4 around the index
+#define SINC_PHASE_BITS 9     // fractional positions in the sinc table
+#define SINC_PHASES (1 << SINC_PHASE_BITS)
+
+typedef enum {
+  INTERP_TRUNCATE,
+  INTERP_LINEAR,
+  INTERP_HERMITE,
+  INTERP_LAGRANGE,
+  INTERP_SINC,
+  INTERP_COUNT
+} interpolation;
+
+// taps for fractional positions 0, 1/SINC_PHASES, ... 1, see interpInit
+extern float sincTable[SINC_PHASES + 1][SINC_TAPS];
+
+// build the sinc table before rendering with INTERP_SINC; later calls do
+// nothing, the first must not race with other threads
+void interpInit(void);
+const char *interpolationName(interpolation interp);
+// name as printed by interpolationName, or INTERP_COUNT if unknown
+interpolation interpolationParse(const char *name);
+// storage for a table of length points is length + 2 * WAVETABLE_GUARD,
+// table points WAVETABLE_GUARD floats into it; fill the guard points
+void wavetableGuard(float *table, unsigned long length);
+
+static inline float interpTruncate(const float *table, int index, float f) {
+  return table[index];
+}
+
+static inline float interpLinear(const float *table, int index, float f) {
+  float y0 = table[index];
+
+  return y0 + f * (table[index + 1] - y0);
+}
+
+static inline float interpHermite(const float *table, int index, float f) {
+  const float *y = table + index;
+  float c1 = .5f * (y[1] - y[-1]);
+  float c2 = y[-1] - 2.5f * y[0] + 2.f * y[1] - .5f * y[2];
+  float c3 = .5f * (y[2] - y[-1]) + 1.5f * (y[0] - y[1]);
+
+  return ((c3 * f + c2) * f + c1) * f + y[0];
+}
+
+static inline float interpLagrange(const float *table, int index, float f) {
+  const float *y = table + index;
+  float fm1 = f - 1.f, fm2 = f - 2.f, fp1 = f + 1.f;
+
+  return -f * fm1 * fm2 * (1.f / 6.f) * y[-1] +
+         fp1 * fm1 * fm2 * .5f * y[0] - fp1 * f * fm2 * .5f * y[1] +
+         fp1 * f * fm1 * (1.f / 6.f) * y[2];
+}
+
+static inline float interpSinc(const float *table, int index, float f) {
+  const float *y = table + index - SINC_TAPS / 2 + 1;
+  float position = f * SINC_PHASES;
+  int row = (int)position;
+  float blend = position - row;
+  const float *a = sincTable[row], *b = sincTable[row + 1];
+  float sum = 0.f;
+  int k;
+
+  // taps for f are blended from the two nearest precomputed rows
+  for (k = 0; k < SINC_TAPS; k++)
+    sum += (a[k] + blend * (b[k] - a[k])) * y[k];
+  return sum;
+}
+
+#endif  // INTERP_H
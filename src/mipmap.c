@@ -0,0 +1,145 @@
+/**
+ *  Purpose:
+ *    band-limited mipmapped wavetables, see mipmap.h
+ *
+ *  mipmap.c
+ */
+
+#include "mipmap.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "interp.h"
+
+#define PI (3.141592653589793)
+
+// fill every level from the full spectrum of one cycle (forward FFT
+// convention of fft.h), normalised so level 0 peaks at 1 unless the cycle
+// is silent
+static int buildLevels(mipmap *m, const double *re, const double *im) {
+  unsigned long n = 1ul << m->tableBits, k, i, harmonics;
+  double *lre = NULL, *lim = NULL, peak = 0.;
+  float *table;
+  fft plan;
+  int l;
+
+  if (fftInit(&plan, m->tableBits) != 0) return -1;
+  lre = malloc(n * sizeof(double));
+  lim = malloc(n * sizeof(double));
+  m->storage =
+      malloc((size_t)m->levels * (n + 2 * WAVETABLE_GUARD) * sizeof(float));
+  if (lre == NULL || lim == NULL || m->storage == NULL) {
+    free(lre);
+    free(lim);
+    fftFree(&plan);
+    mipmapFree(m);
+    return -1;
+  }
+
+  for (l = 0; l < m->levels; l++) {
+    harmonics = (n / 2) >> l;
+    memset(lre, 0, n * sizeof(double));
+    memset(lim, 0, n * sizeof(double));
+    lre[0] = re[0];
+    // keep both halves of every harmonic strictly below Nyquist
+    for (k = 1; k <= harmonics && k < n / 2; k++) {
+      lre[k] = re[k], lim[k] = im[k];
+      lre[n - k] = re[n - k], lim[n - k] = im[n - k];
+    }
+    fftInverse(&plan, lre, lim);
+
+    table =
+        m->storage + (size_t)l * (n + 2 * WAVETABLE_GUARD) + WAVETABLE_GUARD;
+    if (l == 0) {
+      for (i = 0; i < n; i++)
+        if (fabs(lre[i]) > peak) peak = fabs(lre[i]);
+      if (peak == 0.) peak = 1.;  // all zero, every level stays zero
+    }
+    for (i = 0; i < n; i++) table[i] = lre[i] / peak;
+    wavetableGuard(table, n);  // wrapped points for interpolation
+    m->level[l] = table;
+  }
+
+  free(lre);
+  free(lim);
+  fftFree(&plan);
+  return 0;
+}
+
+static int initLevels(mipmap *m, int tableBits) {
+  memset(m, 0, sizeof(*m));
+  if (tableBits < 1 || tableBits > MIPMAP_MAX_LEVELS) return -1;
+  m->tableBits = tableBits;
+  m->levels = tableBits;
+  return 0;
+}
+
+int mipmapInitWaveform(mipmap *m, waveform shape, int tableBits) {
+  unsigned long n = 1ul << tableBits, k;
+  double *re, *im, a;
+  int result;
+
+  if (initLevels(m, tableBits) != 0) return -1;
+  re = calloc(n, sizeof(double));
+  im = calloc(n, sizeof(double));
+  if (re == NULL || im == NULL) {
+    free(re);
+    free(im);
+    return -1;
+  }
+
+  // sine series amplitude of harmonic k, all shapes start at phase 0
+  for (k = 1; k < n / 2; k++) {
+    switch (shape) {
+      case WAVEFORM_SINE:
+        a = k == 1 ? 1. : 0.;
+        break;
+      case WAVEFORM_SAW:
+        a = (k % 2 ? 2. : -2.) / (PI * k);
+        break;
+      case WAVEFORM_SQUARE:
+        a = k % 2 ? 4. / (PI * k) : 0.;
+        break;
+      case WAVEFORM_TRIANGLE:
+        a = k % 2 ? (k % 4 == 1 ? 8. : -8.) / (PI * PI * k * k) : 0.;
+        break;
+      default:
+        a = 0.;
+    }
+    // a sin(x) = a (e^ix - e^-ix) / 2i
+    im[k] = -a * n / 2;
+    im[n - k] = a * n / 2;
+  }
+
+  result = buildLevels(m, re, im);
+  free(re);
+  free(im);
+  return result;
+}
+
+int mipmapInitCycle(mipmap *m, const float *cycle, int tableBits) {
+  unsigned long n = 1ul << tableBits, i;
+  double *re, *im;
+  fft plan;
+  int result = -1;
+
+  if (initLevels(m, tableBits) != 0) return -1;
+  re = malloc(n * sizeof(double));
+  im = calloc(n, sizeof(double));
+  if (re != NULL && im != NULL && fftInit(&plan, tableBits) == 0) {
+    for (i = 0; i < n; i++) re[i] = cycle[i];
+    fftForward(&plan, re, im);
+    fftFree(&plan);
+    result = buildLevels(m, re, im);
+  }
+  free(re);
+  free(im);
+  return result;
+}
+
+void mipmapFree(mipmap *m) {
+  free(m->storage);
+  memset(m, 0, sizeof(*m));
+}
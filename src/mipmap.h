@@ -0,0 +1,68 @@
+/**
+ *  Purpose:
+ *    band-limited mipmapped wavetables, one table per octave
+ *
+ *  mipmap.h
+ *
+ *  A single table holding a saw or square wave aliases badly once it is
+ *  played high, because the harmonics above Nyquist fold back. A mipmap
+ *  keeps one table per octave: level 0 has every harmonic the table can
+ *  hold (up to length / 2), each further level half as many. The tables are
+ *  built once at startup by inverse FFT of the truncated spectrum.
+ *
+ *  mipmapSelect picks, from the phasor increment, the richest level whose
+ *  top harmonic is still below Nyquist. It is meant to be called once per
+ *  block; the per sample lookup stays the plain linear interpolation of
+ *  wavetable2.c on the chosen table.
+ */
+
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <stdint.h>
+
+#define MIPMAP_MAX_LEVELS 24
+
+typedef enum {
+  WAVEFORM_SINE,
+  WAVEFORM_SAW,
+  WAVEFORM_SQUARE,
+  WAVEFORM_TRIANGLE,
+  WAVEFORM_COUNT
+} waveform;
+
+typedef struct {
+  int tableBits;
+  int levels;                         // tableBits levels, 2^tableBits / 2
+                                      // harmonics at level 0 down to one
+  const float *level[MIPMAP_MAX_LEVELS];  // 2^tableBits points, guarded
+                                          // like filltable's tables
+  float *storage;  // NULL for the built-in tables of builtin.h
+} mipmap;
+
+// build from the analytic spectrum of a standard waveform, 0 on success
+int mipmapInitWaveform(mipmap *m, waveform shape, int tableBits);
+// build from one cycle of 2^tableBits samples, e.g. a user wavetable
+int mipmapInitCycle(mipmap *m, const float *cycle, int tableBits);
+void mipmapFree(mipmap *m);
+
+// the level to read at this phasor increment, for any table laid out like
+// a mipmap with levels levels of 2^tableBits points
+static inline int mipmapLevel(int tableBits, int levels, uint32_t increment) {
+  uint64_t harmonics = (1u << tableBits) / 2;
+  int l = 0;
+
+  // the top harmonic moves harmonics * increment / 2^32 cycles per sample
+  while (l < levels - 1 && harmonics * increment >= 0x80000000u) {
+    harmonics >>= 1;
+    l++;
+  }
+  return l;
+}
+
+// the table to read at this phasor increment
+static inline const float *mipmapSelect(const mipmap *m, uint32_t increment) {
+  return m->level[mipmapLevel(m->tableBits, m->levels, increment)];
+}
+
+#endif  // MIPMAP_H
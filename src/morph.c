@@ -0,0 +1,161 @@
+/**
+ *  Purpose:
+ *    multi-frame wavetable oscillator with position scanning, see morph.h
+ *
+ *  morph.c
+ */
+
+#include "morph.h"
+
+#include <math.h>
+#include "mipmap.h"
+#include "phasor.h"
+#include "wavetable.h"
+
+void morphInit(morphwave *m, const float *frames, size_t frameStride,
+               size_t levelStride, int frameCount, int tableBits, int levels,
+               float frequency, float amplitude, double sampleRate) {
+  m->frames = frames;
+  m->frameStride = frameStride;
+  m->levelStride = levelStride;
+  m->frameCount = frameCount;
+  m->tableBits = tableBits;
+  m->levels = levels;
+  m->amplitude = amplitude;
+  m->targetAmplitude = amplitude;
+  m->rampFrames = (unsigned long)(WAVE_RAMP_SECONDS * sampleRate + .5);
+  m->rampLeft = 0;
+  m->position = 0.f;
+  m->targetPosition = 0.f;
+  m->phasor = 0;
+  m->kernel = oscKernelBest();
+  m->sampleRate = sampleRate;
+  morphSetFrequency(m, frequency);
+}
+
+void morphInitBank(morphwave *m, const wavebank *bank, int table,
+                   float frequency, float amplitude, double sampleRate) {
+  const float *frame0 = waveBankTable(bank, table, 0, 0);
+  size_t levelStride = 0, frameStride = 0;
+
+  if (bank->levels > 1)
+    levelStride = (size_t)(waveBankTable(bank, table, 0, 1) - frame0);
+  if (waveBankFrames(bank, table) > 1)
+    frameStride = (size_t)(waveBankTable(bank, table, 1, 0) - frame0);
+  morphInit(m, frame0, frameStride, levelStride, waveBankFrames(bank, table),
+            bank->tableBits, bank->levels, frequency, amplitude, sampleRate);
+}
+
+void morphSetFrequency(morphwave *m, float frequency) {
+  m->frequency = frequency;
+  m->increment = phasorIncrement(frequency, m->sampleRate);
+}
+
+void morphSetAmplitude(morphwave *m, float amplitude) {
+  m->amplitude = m->targetAmplitude = amplitude;
+  m->rampLeft = 0;
+}
+
+void morphRampAmplitude(morphwave *m, float amplitude) {
+  m->targetAmplitude = amplitude;
+  m->rampLeft = m->rampFrames;
+  if (m->rampLeft == 0) m->amplitude = amplitude;
+}
+
+// scale a piece rendered at unit gain by the amplitude ramp, the gain of
+// frame i in closed form
+static void rampPiece(morphwave *m, float *out, unsigned long frames) {
+  const float amp = m->amplitude;
+  const float step = (m->targetAmplitude - amp) / m->rampLeft;
+  unsigned long i;
+  float g;
+
+  for (i = 0; i < frames; i++) {
+    g = amp + (float)i * step;
+    out[2 * i] *= g;
+    out[2 * i + 1] *= g;
+  }
+  m->rampLeft -= frames;
+  m->amplitude = m->rampLeft == 0 ? m->targetAmplitude
+                                  : amp + (float)frames * step;
+}
+
+void morphSetPosition(morphwave *m, float position) {
+  if (position < 0.f) position = 0.f;
+  if (position > m->frameCount - 1) position = (float)(m->frameCount - 1);
+  m->targetPosition = position;
+}
+
+void morphRender(morphwave *m, float *out, unsigned long frames) {
+  const float p0 = m->position;
+  const float dp = frames > 0 ? (m->targetPosition - p0) / frames : 0.f;
+  const int level = mipmapLevel(m->tableBits, m->levels, m->increment);
+  const float *base = m->frames + (size_t)level * m->levelStride;
+  const float *a;
+  unsigned long done = 0, n, reach;
+  float p, amp;
+  int k;
+
+  while (done < frames) {
+    p = p0 + dp * done;
+    k = (int)floorf(p);
+    if (k > m->frameCount - 2) k = m->frameCount - 2;
+    if (k < 0) k = 0;
+    n = frames - done;
+
+    // stop where the glide leaves the pair of frames k, k + 1
+    if (dp > 0.f && k + 1 < m->frameCount - 1) {
+      reach = (unsigned long)ceilf((k + 1 - p) / dp);
+      if (reach > 0 && reach < n) n = reach;
+    } else if (dp < 0.f && k > 0) {
+      reach = (unsigned long)ceilf((p - k) / -dp);
+      if (reach > 0 && reach < n) n = reach;
+    }
+    // and where the amplitude ramp ends
+    if (m->rampLeft > 0 && m->rampLeft < n) n = m->rampLeft;
+    amp = m->rampLeft > 0 ? 1.f : m->amplitude;
+
+    a = base + (size_t)k * m->frameStride;
+    if (m->frameCount < 2 || (dp == 0.f && p == (float)k)) {
+      // exactly on a frame, a plain static render
+      m->kernel->render(a, m->tableBits, &m->phasor, m->increment, amp,
+                        out + 2 * done, n);
+    } else {
+      m->kernel->morph(a, a + m->frameStride, m->tableBits, &m->phasor,
+                       m->increment, amp, p - k, dp, out + 2 * done, n);
+    }
+    if (m->rampLeft > 0) rampPiece(m, out + 2 * done, n);
+    done += n;
+  }
+  m->position = m->targetPosition;
+}
+
+void morphEventHandler(const event *e, void *userData) {
+  morphwave *m = (morphwave *)userData;
+
+  switch (e->type) {
+    case EVENT_NOTE_ON:
+      morphSetFrequency(m, e->value);
+      morphRampAmplitude(m, e->amplitude);
+      break;
+    case EVENT_NOTE_OFF:
+      morphRampAmplitude(m, 0.f);
+      break;
+    case EVENT_PARAM:
+      if (e->key == PARAM_FREQUENCY)
+        morphSetFrequency(m, e->value);
+      else if (e->key == PARAM_AMPLITUDE)
+        morphRampAmplitude(m, e->value);
+      else if (e->key == PARAM_POSITION)
+        morphSetPosition(m, e->value);
+      break;
+  }
+}
+
+int morphCallback(const void *inputBuffer, void *outputBuffer,
+                  unsigned long framesPerBuffer,
+                  const PaStreamCallbackTimeInfo *timeInfo,
+                  PaStreamCallbackFlags statusFlags, void *userData) {
+  morphRender((morphwave *)userData, (float *)outputBuffer, framesPerBuffer);
+  return paContinue;
+}
@@ -0,0 +1,85 @@
+/**
+ *  Purpose:
+ *    multi-frame wavetable oscillator with position scanning
+ *
+ *  morph.h
+ *
+ *  A morphing wave plays a table of several frames (single cycles, e.g. a
+ *  bank table from wavebank.h). Its position, in frames, selects two
+ *  adjacent frames and crossfades between them, so a fractional position
+ *  is a 2D lookup: linear in phase within each frame, linear between the
+ *  frames.
+ *
+ *  The block is rendered by the morph variant of the SIMD kernels of
+ *  osckernel.h, the same linear interpolation as a static wave, reading
+ *  both frames at the phase computed once; a morphing voice costs about
+ *  twice a static one. A new position is reached by a linear glide over
+ *  the next block; where the glide crosses a frame boundary the block is
+ *  split so both frames of a piece stay adjacent.
+ *
+ *  Notes and amplitude events glide to the new amplitude over
+ *  WAVE_RAMP_SECONDS instead of stepping, which would click: the piece is
+ *  rendered at unit gain and scaled by the closed form ramp of wavetable.h,
+ *  amplitude + i * step, so the kernels stay the same.
+ */
+
+#ifndef MORPH_H
+#define MORPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "osckernel.h"
+#include "portaudio.h"
+#include "scheduler.h"
+#include "wavebank.h"
+
+typedef struct {
+  const float *frames;  // frame 0, level 0: 2^tableBits points, guarded
+  size_t frameStride;   // floats from one frame to the next
+  size_t levelStride;   // floats from one mipmap level to the next
+  int frameCount;
+  int tableBits;
+  int levels;           // mipmap levels per frame, 1 without mipmaps
+
+  float frequency;
+  float amplitude;
+  float position;        // in frames, 0 to frameCount - 1
+  float targetPosition;  // position at the end of the next block
+  float targetAmplitude;  // amplitude glides towards while rampLeft > 0
+  unsigned long rampFrames;  // ramp time, 0 makes every change a jump
+  unsigned long rampLeft;    // frames until targetAmplitude is reached
+  uint32_t phasor;
+  uint32_t increment;
+  const osckernel *kernel;
+  double sampleRate;
+} morphwave;
+
+// frames laid out with the given strides, position 0
+void morphInit(morphwave *m, const float *frames, size_t frameStride,
+               size_t levelStride, int frameCount, int tableBits, int levels,
+               float frequency, float amplitude, double sampleRate);
+// every frame and mipmap level of a table in a mapped bank
+void morphInitBank(morphwave *m, const wavebank *bank, int table,
+                   float frequency, float amplitude, double sampleRate);
+void morphSetFrequency(morphwave *m, float frequency);
+// jump to the amplitude at once, for setup code
+void morphSetAmplitude(morphwave *m, float amplitude);
+// glide from the current amplitude to a new one, restarting the ramp
+void morphRampAmplitude(morphwave *m, float amplitude);
+// glide to position (clamped to the frames) over the next block
+void morphSetPosition(morphwave *m, float position);
+// render interleaved stereo
+void morphRender(morphwave *m, float *out, unsigned long frames);
+
+// eventHandler: note on jumps to the frequency and ramps up the amplitude,
+// note off ramps it down to 0, PARAM_FREQUENCY, PARAM_AMPLITUDE (ramped)
+// and PARAM_POSITION are applied
+void morphEventHandler(const event *e, void *userData);
+
+// PaStreamCallback rendering the morphwave passed as userData
+int morphCallback(const void *inputBuffer, void *outputBuffer,
+                  unsigned long framesPerBuffer,
+                  const PaStreamCallbackTimeInfo *timeInfo,
+                  PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // MORPH_H
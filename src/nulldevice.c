@@ -0,0 +1,111 @@
+/**
+ *  Purpose:
+ *    offline "null device" driver, see nulldevice.h
+ *
+ *  nulldevice.c
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "nulldevice.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double nowSeconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+PaError nullDeviceOpen(nulldevice *dev, int channelCount, double sampleRate,
+                       unsigned long framesPerBuffer) {
+  memset(dev, 0, sizeof(*dev));
+  dev->channelCount = channelCount;
+  dev->sampleRate = sampleRate;
+  dev->framesPerBuffer = framesPerBuffer;
+  dev->buffer = calloc(framesPerBuffer * channelCount, sizeof(float));
+  if (dev->buffer == NULL) return paInsufficientMemory;
+
+  return paNoError;
+}
+
+void nullDeviceSetSink(nulldevice *dev, nullDeviceSink sink, void *sinkData) {
+  dev->sink = sink;
+  dev->sinkData = sinkData;
+}
+
+PaError nullDeviceRun(nulldevice *dev, PaStreamCallback *callback,
+                      void *userData, unsigned long long totalFrames) {
+  PaStreamCallbackTimeInfo timeInfo;
+  unsigned long frames;
+  double start, t;
+  int result = paContinue;
+
+  start = nowSeconds();
+  while (result == paContinue && totalFrames > 0) {
+    frames = dev->framesPerBuffer;
+    if (totalFrames < frames) frames = (unsigned long)totalFrames;
+
+    // stream time is the sample clock, there is no real ADC/DAC
+    timeInfo.currentTime = dev->framesRendered / dev->sampleRate;
+    timeInfo.outputBufferDacTime = timeInfo.currentTime;
+    timeInfo.inputBufferAdcTime = 0.;
+
+    t = nowSeconds();
+    result = callback(NULL, dev->buffer, frames, &timeInfo, 0, userData);
+    dev->callbackSeconds += nowSeconds() - t;
+    if (result == paAbort) break;  // aborted buffers are not delivered
+
+    if (dev->sink != NULL &&
+        dev->sink(dev->buffer, frames, dev->channelCount, dev->sinkData) != 0) {
+      dev->totalSeconds += nowSeconds() - start;
+      return paInternalError;
+    }
+    dev->framesRendered += frames;
+    totalFrames -= frames;
+  }
+  dev->totalSeconds += nowSeconds() - start;
+
+  return paNoError;
+}
+
+void nullDeviceClose(nulldevice *dev) {
+  free(dev->buffer);
+  dev->buffer = NULL;
+}
+
+double nullDeviceSpeed(const nulldevice *dev) {
+  if (dev->callbackSeconds <= 0.) return 0.;
+  return dev->framesRendered / dev->sampleRate / dev->callbackSeconds;
+}
+
+int nullDeviceFileSink(const float *buffer, unsigned long frames,
+                       int channelCount, void *sinkData) {
+  FILE *file = (FILE *)sinkData;
+  size_t count = (size_t)frames * channelCount;
+
+  return fwrite(buffer, sizeof(float), count, file) == count ? 0 : -1;
+}
+
+int nullDeviceMemorySink(const float *buffer, unsigned long frames,
+                         int channelCount, void *sinkData) {
+  nullDeviceMemory *mem = (nullDeviceMemory *)sinkData;
+  unsigned long long capacity;
+  float *samples;
+
+  if (mem->frames + frames > mem->capacity) {
+    capacity = mem->capacity ? mem->capacity * 2 : 65536;
+    while (capacity < mem->frames + frames) capacity *= 2;
+    samples = realloc(mem->samples, capacity * channelCount * sizeof(float));
+    if (samples == NULL) return -1;
+    mem->samples = samples;
+    mem->capacity = capacity;
+  }
+  memcpy(mem->samples + mem->frames * channelCount, buffer,
+         (size_t)frames * channelCount * sizeof(float));
+  mem->frames += frames;
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+/**
+ *  Purpose:
+ *    offline "null device" driver for PortAudio style callbacks
+ *
+ *  nulldevice.h
+ *
+ *  Drives a PaStreamCallback (e.g. sineCallback) in a tight loop instead of
+ *  from a sound card. There is no Pa_Sleep pacing, so audio is produced as
+ *  fast as the callback can run. Every buffer is handed to a sink which can
+ *  write it to a file, keep it in memory, or drop it (for pure benchmarks).
+ *
+ *  Only the portaudio.h types are used; nothing here calls into the
+ *  PortAudio library, so offline renders work on hosts with no audio device.
+ */
+
+#ifndef NULLDEVICE_H
+#define NULLDEVICE_H
+
+#include <stdio.h>
+#include "portaudio.h"
+
+// receives each rendered buffer of interleaved frames, returns 0 to go on
+typedef int (*nullDeviceSink)(const float *buffer, unsigned long frames,
+                              int channelCount, void *sinkData);
+
+typedef struct {
+  int channelCount;
+  double sampleRate;
+  unsigned long framesPerBuffer;
+  float *buffer;                       // one callback's interleaved output
+  nullDeviceSink sink;                 // may be NULL: discard output
+  void *sinkData;
+  unsigned long long framesRendered;   // total frames produced so far
+  double callbackSeconds;              // wall time spent inside the callback
+  double totalSeconds;                 // wall time of the whole render
+} nulldevice;
+
+// growable in-memory destination for nullDeviceMemorySink
+typedef struct {
+  float *samples;                      // interleaved, owned by the sink
+  unsigned long long frames;           // frames stored
+  unsigned long long capacity;         // frames allocated
+} nullDeviceMemory;
+
+PaError nullDeviceOpen(nulldevice *dev, int channelCount, double sampleRate,
+                       unsigned long framesPerBuffer);
+void nullDeviceSetSink(nulldevice *dev, nullDeviceSink sink, void *sinkData);
+// call the callback until totalFrames are rendered or it stops returning
+// paContinue; returns paNoError, a sink error or paInsufficientMemory
+PaError nullDeviceRun(nulldevice *dev, PaStreamCallback *callback,
+                      void *userData, unsigned long long totalFrames);
+void nullDeviceClose(nulldevice *dev);
+// rendered seconds of audio per wall clock second spent in the callback
+double nullDeviceSpeed(const nulldevice *dev);
+
+// sinkData is a FILE *, frames are written as raw native float32
+int nullDeviceFileSink(const float *buffer, unsigned long frames,
+                       int channelCount, void *sinkData);
+// sinkData is a nullDeviceMemory *, free its samples when done
+int nullDeviceMemorySink(const float *buffer, unsigned long frames,
+                         int channelCount, void *sinkData);
+
+#endif  // NULLDEVICE_H
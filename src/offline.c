@@ -0,0 +1,57 @@
+/**
+ *  Purpose:
+ *    offline rendering of a stream callback to a file, see offline.h
+ *
+ *  offline.c
+ */
+
+#include "offline.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "nulldevice.h"
+#include "wavwriter.h"
+
+PaError renderOffline(PaStreamCallback *callback, void *data,
+                      const char *path, double seconds, double sampleRate,
+                      unsigned long framesPerBuffer) {
+  nulldevice dev;
+  wavwriter writer;
+  FILE *file = NULL;
+  size_t length = strlen(path);
+  int wav = length > 4 && strcmp(path + length - 4, ".wav") == 0;
+  PaError err;
+
+  err = nullDeviceOpen(&dev, 2, sampleRate, framesPerBuffer);
+  if (err != paNoError) return err;
+  if (wav) {
+    if (wavWriterOpen(&writer, path, 2, sampleRate, 4.) != 0) {
+      fprintf(stderr, "Error: cannot open %s.\n", path);
+      nullDeviceClose(&dev);
+      return paInternalError;
+    }
+    nullDeviceSetSink(&dev, wavWriterSink, &writer);
+  } else if (strcmp(path, "-") != 0) {
+    file = fopen(path, "wb");
+    if (file == NULL) {
+      fprintf(stderr, "Error: cannot open %s.\n", path);
+      nullDeviceClose(&dev);
+      return paInternalError;
+    }
+    nullDeviceSetSink(&dev, nullDeviceFileSink, file);
+  }
+
+  err = nullDeviceRun(&dev, callback, data,
+                      (unsigned long long)(seconds * sampleRate));
+  printf("Rendered %.2f s in %.3f s callback time (%.1fx real time).\n",
+         dev.framesRendered / sampleRate, dev.callbackSeconds,
+         nullDeviceSpeed(&dev));
+
+  if (file != NULL && fclose(file) != 0 && err == paNoError)
+    err = paInternalError;
+  if (wav && wavWriterClose(&writer) != 0 && err == paNoError)
+    err = paInternalError;
+  nullDeviceClose(&dev);
+
+  return err;
+}
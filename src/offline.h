@@ -0,0 +1,24 @@
+/**
+ *  Purpose:
+ *    offline rendering of a stream callback to a file, shared by the demos
+ *
+ *  offline.h
+ *
+ *  Runs the callback through the null device instead of the sound card.
+ *  The path "-" discards the output, which measures the callback on its
+ *  own. A path ending in .wav gets a float WAV/RF64 file from wavwriter,
+ *  anything else raw interleaved float32.
+ */
+
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+#include "portaudio.h"
+
+// render seconds of stereo audio and print how much faster than real time
+// the callback ran
+PaError renderOffline(PaStreamCallback *callback, void *data,
+                      const char *path, double seconds, double sampleRate,
+                      unsigned long framesPerBuffer);
+
+#endif  // OFFLINE_H
@@ -0,0 +1,542 @@
+/**
+ *  Purpose:
+ *    block wavetable kernels with SIMD variants, see osckernel.h
+ *
+ *  osckernel.c
+ *
+ *  All kernels evaluate y = amplitude * (y0 + f * (y1 - y0)) in the same
+ *  order, with the fraction taken from the top 24 bits below the index like
+ *  phasorFraction; the morph kernels mix the two tables' values with
+ *  ya + x * (yb - ya) before the amplitude. The AVX2 kernels are compiled
+ *  with a target attribute, so no -mavx2 is needed and they are only called
+ *  when the CPU reports AVX2.
+ */
+
+#include "osckernel.h"
+
+#include "phasor.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OSCKERNEL_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define OSCKERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define FRACTION_SCALE (1.f / 16777216.f)  // 2^-24
+
+static void renderScalar(const float *table, int tableBits, uint32_t *phase,
+                         uint32_t increment, float amplitude, float *out,
+                         unsigned long frames) {
+  uint32_t p = *phase;
+  uint32_t index;
+  unsigned long i;
+  float f, y0, y;
+
+  for (i = 0; i < frames; i++) {
+    index = phasorIndex(p, tableBits);
+    f = phasorFraction(p, tableBits);
+    y0 = table[index];
+    y = amplitude * (y0 + f * (table[index + 1] - y0));
+    p += increment;
+    *out++ = y;  // left channel
+    *out++ = y;  // right channel
+  }
+  *phase = p;
+}
+
+static void morphScalar(const float *table, const float *next, int tableBits,
+                        uint32_t *phase, uint32_t increment, float amplitude,
+                        float position, float positionStep, float *out,
+                        unsigned long frames) {
+  uint32_t p = *phase;
+  uint32_t index;
+  unsigned long i;
+  float f, x, ya, yb, y;
+
+  for (i = 0; i < frames; i++) {
+    index = phasorIndex(p, tableBits);
+    f = phasorFraction(p, tableBits);
+    x = position + (float)i * positionStep;
+    ya = table[index] + f * (table[index + 1] - table[index]);
+    yb = next[index] + f * (next[index + 1] - next[index]);
+    y = amplitude * (ya + x * (yb - ya));
+    p += increment;
+    *out++ = y;
+    *out++ = y;
+  }
+  *phase = p;
+}
+
+static void unisonScalar(const float *table, int tableBits, uint32_t *phase,
+                         const uint32_t *increment, const float *left,
+                         const float *right, int copies, float *out,
+                         unsigned long frames) {
+  uint32_t p[OSC_UNISON_MAX];
+  uint32_t index;
+  unsigned long i;
+  float f, y0, y, l, r;
+  int c;
+
+  for (c = 0; c < copies; c++) p[c] = phase[c];
+  for (i = 0; i < frames; i++) {
+    l = r = 0.f;
+    for (c = 0; c < copies; c++) {
+      index = phasorIndex(p[c], tableBits);
+      f = phasorFraction(p[c], tableBits);
+      y0 = table[index];
+      y = y0 + f * (table[index + 1] - y0);
+      l += left[c] * y;
+      r += right[c] * y;
+      p[c] += increment[c];
+    }
+    *out++ = l;
+    *out++ = r;
+  }
+  for (c = 0; c < copies; c++) phase[c] = p[c];
+}
+
+#if defined(OSCKERNEL_X86) && defined(__SSE2__)
+#define OSCKERNEL_SSE2 1
+
+// four lanes; SSE2 has no gather, so the eight table reads are scalar
+static void renderSse2(const float *table, int tableBits, uint32_t *phase,
+                       uint32_t increment, float amplitude, float *out,
+                       unsigned long frames) {
+  uint32_t p = *phase;
+  unsigned long i, blocks = frames / 4;
+  __m128i ph = _mm_setr_epi32(p, p + increment, p + 2 * increment,
+                              p + 3 * increment);
+  const __m128i step = _mm_set1_epi32(4 * increment);
+  const __m128i indexShift = _mm_cvtsi32_si128(32 - tableBits);
+  const __m128i fractionShift = _mm_cvtsi32_si128(tableBits);
+  const __m128 scale = _mm_set1_ps(FRACTION_SCALE);
+  const __m128 amp = _mm_set1_ps(amplitude);
+  int32_t idx[4];
+  __m128 f, y0, y1, y;
+
+  for (i = 0; i < blocks; i++) {
+    _mm_storeu_si128((__m128i *)idx, _mm_srl_epi32(ph, indexShift));
+    f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(
+                       _mm_sll_epi32(ph, fractionShift), 8)),
+                   scale);
+    y0 = _mm_setr_ps(table[idx[0]], table[idx[1]], table[idx[2]],
+                     table[idx[3]]);
+    y1 = _mm_setr_ps(table[idx[0] + 1], table[idx[1] + 1], table[idx[2] + 1],
+                     table[idx[3] + 1]);
+    y = _mm_mul_ps(amp, _mm_add_ps(y0, _mm_mul_ps(f, _mm_sub_ps(y1, y0))));
+    // duplicate each mono sample into a left/right pair
+    _mm_storeu_ps(out, _mm_unpacklo_ps(y, y));
+    _mm_storeu_ps(out + 4, _mm_unpackhi_ps(y, y));
+    out += 8;
+    ph = _mm_add_epi32(ph, step);
+  }
+  p += (uint32_t)(blocks * 4) * increment;
+  renderScalar(table, tableBits, &p, increment, amplitude, out, frames % 4);
+  *phase = p;
+}
+
+static void morphSse2(const float *table, const float *next, int tableBits,
+                      uint32_t *phase, uint32_t increment, float amplitude,
+                      float position, float positionStep, float *out,
+                      unsigned long frames) {
+  uint32_t p = *phase;
+  unsigned long i, blocks = frames / 4;
+  __m128i ph = _mm_setr_epi32(p, p + increment, p + 2 * increment,
+                              p + 3 * increment);
+  const __m128i step = _mm_set1_epi32(4 * increment);
+  const __m128i indexShift = _mm_cvtsi32_si128(32 - tableBits);
+  const __m128i fractionShift = _mm_cvtsi32_si128(tableBits);
+  const __m128 scale = _mm_set1_ps(FRACTION_SCALE);
+  const __m128 amp = _mm_set1_ps(amplitude);
+  const __m128 xStep = _mm_set1_ps(4.f * positionStep);
+  __m128 x = _mm_add_ps(
+      _mm_set1_ps(position),
+      _mm_mul_ps(_mm_setr_ps(0.f, 1.f, 2.f, 3.f), _mm_set1_ps(positionStep)));
+  int32_t idx[4];
+  __m128 f, y0, y1, ya, yb, y;
+
+  for (i = 0; i < blocks; i++) {
+    _mm_storeu_si128((__m128i *)idx, _mm_srl_epi32(ph, indexShift));
+    f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(
+                       _mm_sll_epi32(ph, fractionShift), 8)),
+                   scale);
+    y0 = _mm_setr_ps(table[idx[0]], table[idx[1]], table[idx[2]],
+                     table[idx[3]]);
+    y1 = _mm_setr_ps(table[idx[0] + 1], table[idx[1] + 1], table[idx[2] + 1],
+                     table[idx[3] + 1]);
+    ya = _mm_add_ps(y0, _mm_mul_ps(f, _mm_sub_ps(y1, y0)));
+    y0 = _mm_setr_ps(next[idx[0]], next[idx[1]], next[idx[2]], next[idx[3]]);
+    y1 = _mm_setr_ps(next[idx[0] + 1], next[idx[1] + 1], next[idx[2] + 1],
+                     next[idx[3] + 1]);
+    yb = _mm_add_ps(y0, _mm_mul_ps(f, _mm_sub_ps(y1, y0)));
+    y = _mm_mul_ps(amp, _mm_add_ps(ya, _mm_mul_ps(x, _mm_sub_ps(yb, ya))));
+    _mm_storeu_ps(out, _mm_unpacklo_ps(y, y));
+    _mm_storeu_ps(out + 4, _mm_unpackhi_ps(y, y));
+    out += 8;
+    ph = _mm_add_epi32(ph, step);
+    x = _mm_add_ps(x, xStep);
+  }
+  p += (uint32_t)(blocks * 4) * increment;
+  morphScalar(table, next, tableBits, &p, increment, amplitude,
+              position + (float)(blocks * 4) * positionStep, positionStep, out,
+              frames % 4);
+  *phase = p;
+}
+
+// four copies per register, summed across lanes into the pair every frame
+static void unisonSse2(const float *table, int tableBits, uint32_t *phase,
+                       const uint32_t *increment, const float *left,
+                       const float *right, int copies, float *out,
+                       unsigned long frames) {
+  const int groups = copies / 4;
+  const __m128i indexShift = _mm_cvtsi32_si128(32 - tableBits);
+  const __m128i fractionShift = _mm_cvtsi32_si128(tableBits);
+  const __m128 scale = _mm_set1_ps(FRACTION_SCALE);
+  __m128i ph[OSC_UNISON_MAX / 4], inc[OSC_UNISON_MAX / 4];
+  __m128 gl[OSC_UNISON_MAX / 4], gr[OSC_UNISON_MAX / 4];
+  __m128 f, y0, y1, y, l, r, pair;
+  unsigned long i;
+  int32_t idx[4];
+  int g;
+
+  for (g = 0; g < groups; g++) {
+    ph[g] = _mm_loadu_si128((const __m128i *)(phase + 4 * g));
+    inc[g] = _mm_loadu_si128((const __m128i *)(increment + 4 * g));
+    gl[g] = _mm_loadu_ps(left + 4 * g);
+    gr[g] = _mm_loadu_ps(right + 4 * g);
+  }
+  for (i = 0; i < frames; i++) {
+    l = r = _mm_setzero_ps();
+    for (g = 0; g < groups; g++) {
+      _mm_storeu_si128((__m128i *)idx, _mm_srl_epi32(ph[g], indexShift));
+      f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(
+                         _mm_sll_epi32(ph[g], fractionShift), 8)),
+                     scale);
+      y0 = _mm_setr_ps(table[idx[0]], table[idx[1]], table[idx[2]],
+                       table[idx[3]]);
+      y1 = _mm_setr_ps(table[idx[0] + 1], table[idx[1] + 1],
+                       table[idx[2] + 1], table[idx[3] + 1]);
+      y = _mm_add_ps(y0, _mm_mul_ps(f, _mm_sub_ps(y1, y0)));
+      l = _mm_add_ps(l, _mm_mul_ps(gl[g], y));
+      r = _mm_add_ps(r, _mm_mul_ps(gr[g], y));
+      ph[g] = _mm_add_epi32(ph[g], inc[g]);
+    }
+    // [l0 r0 l1 r1] + [l2 r2 l3 r3], then the two halves
+    pair = _mm_add_ps(_mm_unpacklo_ps(l, r), _mm_unpackhi_ps(l, r));
+    pair = _mm_add_ps(pair, _mm_movehl_ps(pair, pair));
+    _mm_storel_pi((__m64 *)out, pair);
+    out += 2;
+  }
+  for (g = 0; g < groups; g++)
+    _mm_storeu_si128((__m128i *)(phase + 4 * g), ph[g]);
+}
+
+// eight lanes with hardware gathers for both interpolation points
+__attribute__((target("avx2"))) static void renderAvx2(
+    const float *table, int tableBits, uint32_t *phase, uint32_t increment,
+    float amplitude, float *out, unsigned long frames) {
+  uint32_t p = *phase;
+  unsigned long i, blocks = frames / 8;
+  __m256i ph = _mm256_add_epi32(
+      _mm256_set1_epi32(p),
+      _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                         _mm256_set1_epi32(increment)));
+  const __m256i step = _mm256_set1_epi32(8 * increment);
+  const __m128i indexShift = _mm_cvtsi32_si128(32 - tableBits);
+  const __m128i fractionShift = _mm_cvtsi32_si128(tableBits);
+  const __m256 scale = _mm256_set1_ps(FRACTION_SCALE);
+  const __m256 amp = _mm256_set1_ps(amplitude);
+  __m256i idx;
+  __m256 f, y0, y1, y, lo, hi;
+
+  for (i = 0; i < blocks; i++) {
+    idx = _mm256_srl_epi32(ph, indexShift);
+    f = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(
+                          _mm256_sll_epi32(ph, fractionShift), 8)),
+                      scale);
+    y0 = _mm256_i32gather_ps(table, idx, 4);
+    y1 = _mm256_i32gather_ps(table + 1, idx, 4);
+    y = _mm256_mul_ps(
+        amp, _mm256_add_ps(y0, _mm256_mul_ps(f, _mm256_sub_ps(y1, y0))));
+    // unpack works per 128-bit half, the permutes restore sample order
+    lo = _mm256_unpacklo_ps(y, y);
+    hi = _mm256_unpackhi_ps(y, y);
+    _mm256_storeu_ps(out, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    out += 16;
+    ph = _mm256_add_epi32(ph, step);
+  }
+  p += (uint32_t)(blocks * 8) * increment;
+  renderScalar(table, tableBits, &p, increment, amplitude, out, frames % 8);
+  *phase = p;
+}
+
+__attribute__((target("avx2"))) static void morphAvx2(
+    const float *table, const float *next, int tableBits, uint32_t *phase,
+    uint32_t increment, float amplitude, float position, float positionStep,
+    float *out, unsigned long frames) {
+  uint32_t p = *phase;
+  unsigned long i, blocks = frames / 8;
+  const __m256 lanes = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+  __m256i ph = _mm256_add_epi32(
+      _mm256_set1_epi32(p),
+      _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                         _mm256_set1_epi32(increment)));
+  const __m256i step = _mm256_set1_epi32(8 * increment);
+  const __m128i indexShift = _mm_cvtsi32_si128(32 - tableBits);
+  const __m128i fractionShift = _mm_cvtsi32_si128(tableBits);
+  const __m256 scale = _mm256_set1_ps(FRACTION_SCALE);
+  const __m256 amp = _mm256_set1_ps(amplitude);
+  const __m256 xStep = _mm256_set1_ps(8.f * positionStep);
+  __m256 x = _mm256_add_ps(_mm256_set1_ps(position),
+                           _mm256_mul_ps(lanes, _mm256_set1_ps(positionStep)));
+  __m256i idx;
+  __m256 f, y0, y1, ya, yb, y, lo, hi;
+
+  for (i = 0; i < blocks; i++) {
+    idx = _mm256_srl_epi32(ph, indexShift);
+    f = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(
+                          _mm256_sll_epi32(ph, fractionShift), 8)),
+                      scale);
+    y0 = _mm256_i32gather_ps(table, idx, 4);
+    y1 = _mm256_i32gather_ps(table + 1, idx, 4);
+    ya = _mm256_add_ps(y0, _mm256_mul_ps(f, _mm256_sub_ps(y1, y0)));
+    y0 = _mm256_i32gather_ps(next, idx, 4);
+    y1 = _mm256_i32gather_ps(next + 1, idx, 4);
+    yb = _mm256_add_ps(y0, _mm256_mul_ps(f, _mm256_sub_ps(y1, y0)));
+    y = _mm256_mul_ps(
+        amp, _mm256_add_ps(ya, _mm256_mul_ps(x, _mm256_sub_ps(yb, ya))));
+    lo = _mm256_unpacklo_ps(y, y);
+    hi = _mm256_unpackhi_ps(y, y);
+    _mm256_storeu_ps(out, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    out += 16;
+    ph = _mm256_add_epi32(ph, step);
+    x = _mm256_add_ps(x, xStep);
+  }
+  p += (uint32_t)(blocks * 8) * increment;
+  morphScalar(table, next, tableBits, &p, increment, amplitude,
+              position + (float)(blocks * 8) * positionStep, positionStep, out,
+              frames % 8);
+  *phase = p;
+}
+
+__attribute__((target("avx2"))) static void unisonAvx2(
+    const float *table, int tableBits, uint32_t *phase,
+    const uint32_t *increment, const float *left, const float *right,
+    int copies, float *out, unsigned long frames) {
+  const int groups = copies / 8;
+  const __m128i indexShift = _mm_cvtsi32_si128(32 - tableBits);
+  const __m128i fractionShift = _mm_cvtsi32_si128(tableBits);
+  const __m256 scale = _mm256_set1_ps(FRACTION_SCALE);
+  __m256i ph[OSC_UNISON_MAX / 8], inc[OSC_UNISON_MAX / 8], idx;
+  __m256 gl[OSC_UNISON_MAX / 8], gr[OSC_UNISON_MAX / 8];
+  __m256 f, y0, y1, y, l, r, sums;
+  __m128 pair;
+  unsigned long i;
+  int g;
+
+  for (g = 0; g < groups; g++) {
+    ph[g] = _mm256_loadu_si256((const __m256i *)(phase + 8 * g));
+    inc[g] = _mm256_loadu_si256((const __m256i *)(increment + 8 * g));
+    gl[g] = _mm256_loadu_ps(left + 8 * g);
+    gr[g] = _mm256_loadu_ps(right + 8 * g);
+  }
+  for (i = 0; i < frames; i++) {
+    l = r = _mm256_setzero_ps();
+    for (g = 0; g < groups; g++) {
+      idx = _mm256_srl_epi32(ph[g], indexShift);
+      f = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(
+                            _mm256_sll_epi32(ph[g], fractionShift), 8)),
+                        scale);
+      y0 = _mm256_i32gather_ps(table, idx, 4);
+      y1 = _mm256_i32gather_ps(table + 1, idx, 4);
+      y = _mm256_add_ps(y0, _mm256_mul_ps(f, _mm256_sub_ps(y1, y0)));
+      l = _mm256_add_ps(l, _mm256_mul_ps(gl[g], y));
+      r = _mm256_add_ps(r, _mm256_mul_ps(gr[g], y));
+      ph[g] = _mm256_add_epi32(ph[g], inc[g]);
+    }
+    // per 128-bit half [l r l r] after two horizontal adds, then the halves
+    sums = _mm256_hadd_ps(l, r);
+    sums = _mm256_hadd_ps(sums, sums);
+    pair = _mm_add_ps(_mm256_castps256_ps128(sums),
+                      _mm256_extractf128_ps(sums, 1));
+    _mm_storel_pi((__m64 *)out, pair);
+    out += 2;
+  }
+  for (g = 0; g < groups; g++)
+    _mm256_storeu_si256((__m256i *)(phase + 8 * g), ph[g]);
+}
+#endif
+
+#if defined(OSCKERNEL_NEON)
+static void renderNeon(const float *table, int tableBits, uint32_t *phase,
+                       uint32_t increment, float amplitude, float *out,
+                       unsigned long frames) {
+  static const uint32_t lanes[4] = {0, 1, 2, 3};
+  uint32_t p = *phase;
+  unsigned long i, blocks = frames / 4;
+  uint32x4_t ph = vmlaq_n_u32(vdupq_n_u32(p), vld1q_u32(lanes), increment);
+  const uint32x4_t step = vdupq_n_u32(4 * increment);
+  const int32x4_t indexShift = vdupq_n_s32(-(32 - tableBits));  // right
+  const int32x4_t fractionShift = vdupq_n_s32(tableBits);
+  uint32_t idx[4];
+  float32x4_t f, y0, y1, y;
+  float32x4x2_t stereo;
+
+  for (i = 0; i < blocks; i++) {
+    vst1q_u32(idx, vshlq_u32(ph, indexShift));
+    f = vmulq_n_f32(
+        vcvtq_f32_u32(vshrq_n_u32(vshlq_u32(ph, fractionShift), 8)),
+        FRACTION_SCALE);
+    y0 = vld1q_lane_f32(table + idx[0], vdupq_n_f32(0.f), 0);
+    y0 = vld1q_lane_f32(table + idx[1], y0, 1);
+    y0 = vld1q_lane_f32(table + idx[2], y0, 2);
+    y0 = vld1q_lane_f32(table + idx[3], y0, 3);
+    y1 = vld1q_lane_f32(table + idx[0] + 1, vdupq_n_f32(0.f), 0);
+    y1 = vld1q_lane_f32(table + idx[1] + 1, y1, 1);
+    y1 = vld1q_lane_f32(table + idx[2] + 1, y1, 2);
+    y1 = vld1q_lane_f32(table + idx[3] + 1, y1, 3);
+    y = vmulq_n_f32(vaddq_f32(y0, vmulq_f32(f, vsubq_f32(y1, y0))),
+                    amplitude);
+    stereo.val[0] = y;
+    stereo.val[1] = y;
+    vst2q_f32(out, stereo);  // interleaving store
+    out += 8;
+    ph = vaddq_u32(ph, step);
+  }
+  p += (uint32_t)(blocks * 4) * increment;
+  renderScalar(table, tableBits, &p, increment, amplitude, out, frames % 4);
+  *phase = p;
+}
+
+// table[idx[k] + offset] in lane k
+static inline float32x4_t gatherNeon(const float *table, const uint32_t *idx,
+                                     int offset) {
+  float32x4_t y = vld1q_lane_f32(table + idx[0] + offset, vdupq_n_f32(0.f), 0);
+
+  y = vld1q_lane_f32(table + idx[1] + offset, y, 1);
+  y = vld1q_lane_f32(table + idx[2] + offset, y, 2);
+  return vld1q_lane_f32(table + idx[3] + offset, y, 3);
+}
+
+static void morphNeon(const float *table, const float *next, int tableBits,
+                      uint32_t *phase, uint32_t increment, float amplitude,
+                      float position, float positionStep, float *out,
+                      unsigned long frames) {
+  static const uint32_t lanes[4] = {0, 1, 2, 3};
+  static const float lanesf[4] = {0.f, 1.f, 2.f, 3.f};
+  uint32_t p = *phase;
+  unsigned long i, blocks = frames / 4;
+  uint32x4_t ph = vmlaq_n_u32(vdupq_n_u32(p), vld1q_u32(lanes), increment);
+  const uint32x4_t step = vdupq_n_u32(4 * increment);
+  const int32x4_t indexShift = vdupq_n_s32(-(32 - tableBits));  // right
+  const int32x4_t fractionShift = vdupq_n_s32(tableBits);
+  float32x4_t x = vmlaq_n_f32(vdupq_n_f32(position), vld1q_f32(lanesf),
+                              positionStep);
+  uint32_t idx[4];
+  float32x4_t f, y0, y1, ya, yb, y;
+  float32x4x2_t stereo;
+
+  for (i = 0; i < blocks; i++) {
+    vst1q_u32(idx, vshlq_u32(ph, indexShift));
+    f = vmulq_n_f32(
+        vcvtq_f32_u32(vshrq_n_u32(vshlq_u32(ph, fractionShift), 8)),
+        FRACTION_SCALE);
+    y0 = gatherNeon(table, idx, 0);
+    y1 = gatherNeon(table, idx, 1);
+    ya = gatherNeon(next, idx, 0);
+    yb = gatherNeon(next, idx, 1);
+    yb = vaddq_f32(ya, vmulq_f32(f, vsubq_f32(yb, ya)));
+    ya = vaddq_f32(y0, vmulq_f32(f, vsubq_f32(y1, y0)));
+    y = vmulq_n_f32(vaddq_f32(ya, vmulq_f32(x, vsubq_f32(yb, ya))),
+                    amplitude);
+    stereo.val[0] = y;
+    stereo.val[1] = y;
+    vst2q_f32(out, stereo);
+    out += 8;
+    ph = vaddq_u32(ph, step);
+    x = vaddq_f32(x, vdupq_n_f32(4.f * positionStep));
+  }
+  p += (uint32_t)(blocks * 4) * increment;
+  morphScalar(table, next, tableBits, &p, increment, amplitude,
+              position + (float)(blocks * 4) * positionStep, positionStep, out,
+              frames % 4);
+  *phase = p;
+}
+
+static void unisonNeon(const float *table, int tableBits, uint32_t *phase,
+                       const uint32_t *increment, const float *left,
+                       const float *right, int copies, float *out,
+                       unsigned long frames) {
+  const int groups = copies / 4;
+  const int32x4_t indexShift = vdupq_n_s32(-(32 - tableBits));  // right
+  const int32x4_t fractionShift = vdupq_n_s32(tableBits);
+  uint32x4_t ph[OSC_UNISON_MAX / 4], inc[OSC_UNISON_MAX / 4];
+  float32x4_t gl[OSC_UNISON_MAX / 4], gr[OSC_UNISON_MAX / 4];
+  float32x4_t f, y0, y1, y, l, r;
+  float32x2_t pl, pr;
+  unsigned long i;
+  uint32_t idx[4];
+  int g;
+
+  for (g = 0; g < groups; g++) {
+    ph[g] = vld1q_u32(phase + 4 * g);
+    inc[g] = vld1q_u32(increment + 4 * g);
+    gl[g] = vld1q_f32(left + 4 * g);
+    gr[g] = vld1q_f32(right + 4 * g);
+  }
+  for (i = 0; i < frames; i++) {
+    l = r = vdupq_n_f32(0.f);
+    for (g = 0; g < groups; g++) {
+      vst1q_u32(idx, vshlq_u32(ph[g], indexShift));
+      f = vmulq_n_f32(
+          vcvtq_f32_u32(vshrq_n_u32(vshlq_u32(ph[g], fractionShift), 8)),
+          FRACTION_SCALE);
+      y0 = gatherNeon(table, idx, 0);
+      y1 = gatherNeon(table, idx, 1);
+      y = vaddq_f32(y0, vmulq_f32(f, vsubq_f32(y1, y0)));
+      l = vmlaq_f32(l, gl[g], y);
+      r = vmlaq_f32(r, gr[g], y);
+      ph[g] = vaddq_u32(ph[g], inc[g]);
+    }
+    pl = vpadd_f32(vget_low_f32(l), vget_high_f32(l));
+    pr = vpadd_f32(vget_low_f32(r), vget_high_f32(r));
+    vst1_f32(out, vpadd_f32(pl, pr));  // the pair l, r
+    out += 2;
+  }
+  for (g = 0; g < groups; g++) vst1q_u32(phase + 4 * g, ph[g]);
+}
+#endif
+
+// ordered by feature level, so the supported kernels are a prefix
+static const osckernel kernels[] = {
+    {"scalar", renderScalar, morphScalar, unisonScalar},
+#if defined(OSCKERNEL_SSE2)
+    {"sse2", renderSse2, morphSse2, unisonSse2},
+    {"avx2", renderAvx2, morphAvx2, unisonAvx2},
+#endif
+#if defined(OSCKERNEL_NEON)
+    {"neon", renderNeon, morphNeon, unisonNeon},
+#endif
+};
+
+const osckernel *oscKernelList(int *count) {
+  int n = sizeof(kernels) / sizeof(kernels[0]);
+
+#if defined(OSCKERNEL_SSE2)
+  if (!__builtin_cpu_supports("avx2")) n--;
+#endif
+  *count = n;
+  return kernels;
+}
+
+const osckernel *oscKernelBest(void) {
+  int count;
+  const osckernel *list = oscKernelList(&count);
+
+  return &list[count - 1];
+}
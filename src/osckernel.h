@@ -0,0 +1,68 @@
+/**
+ *  Purpose:
+ *    block wavetable kernels with SIMD variants and runtime dispatch
+ *
+ *  osckernel.h
+ *
+ *  A kernel renders a whole block of one phasor driven oscillator with the
+ *  linear interpolation of wavetable2.c, writing interleaved stereo. The
+ *  vector kernels compute several phases at once (phase + k * increment),
+ *  look the table up per lane and store left/right pairs with one shuffle,
+ *  instead of carrying the table position from sample to sample.
+ *
+ *  The morph variant reads two tables at the same phase and crossfades
+ *  them, the 2D (phase x frame) lookup of morph.h. Index and fraction are
+ *  computed once for both, so it costs little more than twice the reads.
+ *
+ *  The unison variant renders up to OSC_UNISON_MAX copies of the oscillator,
+ *  each with its own phase and increment, one copy per lane. Every copy is
+ *  panned with its own left and right gain and the lanes are summed into
+ *  the stereo pair, so the output is no longer a mono sample written twice.
+ *
+ *  All kernels compute the same interpolation. The fastest one the CPU
+ *  supports is picked at run time, so one binary runs on SSE2-only and
+ *  AVX2 hosts; on ARM the NEON kernel is used and elsewhere the scalar one.
+ */
+
+#ifndef OSCKERNEL_H
+#define OSCKERNEL_H
+
+#include <stdint.h>
+
+// table holds 2^tableBits points plus one guard point equal to table[0];
+// phase is advanced by frames * increment
+typedef void (*oscKernelFunc)(const float *table, int tableBits,
+                              uint32_t *phase, uint32_t increment,
+                              float amplitude, float *out,
+                              unsigned long frames);
+
+// table and next as above, next weighted by position + i * positionStep in
+// frame i of the block
+typedef void (*oscMorphFunc)(const float *table, const float *next,
+                             int tableBits, uint32_t *phase,
+                             uint32_t increment, float amplitude,
+                             float position, float positionStep, float *out,
+                             unsigned long frames);
+
+#define OSC_UNISON_MAX 16  // copies of a unison kernel, a multiple of 8
+
+// copies is a multiple of 8 up to OSC_UNISON_MAX (pad with zero gains);
+// phase[c] of every copy is advanced by frames * increment[c]
+typedef void (*oscUnisonFunc)(const float *table, int tableBits,
+                              uint32_t *phase, const uint32_t *increment,
+                              const float *left, const float *right,
+                              int copies, float *out, unsigned long frames);
+
+typedef struct {
+  const char *name;
+  oscKernelFunc render;
+  oscMorphFunc morph;
+  oscUnisonFunc unison;
+} osckernel;
+
+// the fastest kernel this CPU can run
+const osckernel *oscKernelBest(void);
+// kernels this CPU can run, slowest first; count receives the length
+const osckernel *oscKernelList(int *count);
+
+#endif  // OSCKERNEL_H
@@ -0,0 +1,30 @@
+/**
+ *  Purpose:
+ *    lock-free parameter changes to the audio callback, see paramqueue.h
+ *
+ *  paramqueue.c
+ */
+
+#include "paramqueue.h"
+
+int paramQueueInit(paramqueue *queue, size_t capacity) {
+  atomic_init(&queue->dropped, 0);
+  return ringBufferInit(&queue->ring, sizeof(paramchange), capacity);
+}
+
+void paramQueueFree(paramqueue *queue) { ringBufferFree(&queue->ring); }
+
+int paramQueueSend(paramqueue *queue, parameter param, float value) {
+  paramchange change;
+
+  change.param = param;
+  change.value = value;
+  if (ringBufferWrite(&queue->ring, &change, 1) == 1) return 0;
+  atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+  return -1;
+}
+
+size_t paramQueueReceive(paramqueue *queue, paramchange *changes,
+                         size_t max) {
+  return ringBufferRead(&queue->ring, changes, max);
+}
@@ -0,0 +1,50 @@
+/**
+ *  Purpose:
+ *    lock-free parameter changes from a control thread to the audio callback
+ *
+ *  paramqueue.h
+ *
+ *  Frequency, amplitude and phase of a playing wave are changed by sending
+ *  small messages through a single producer / single consumer ring buffer.
+ *  The control thread never waits: a send into a full queue fails and is
+ *  counted. The callback drains everything pending at the start of each
+ *  block, in order, so a message is applied whole or not at all and a
+ *  float can never be read half written.
+ */
+
+#ifndef PARAMQUEUE_H
+#define PARAMQUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "ringbuffer.h"
+
+#define PARAMQUEUE_BATCH 64  // changes copied out of the ring at a time
+
+typedef enum {
+  PARAM_FREQUENCY,
+  PARAM_AMPLITUDE,
+  PARAM_PHASE,
+  PARAM_POSITION  // frame of a morphing wavetable, see morph.h
+} parameter;
+
+typedef struct {
+  parameter param;
+  float value;  // Hz, linear gain, cycles for PARAM_PHASE, frames
+} paramchange;
+
+typedef struct {
+  ringbuffer ring;        // paramchange elements
+  atomic_ullong dropped;  // sends refused because the queue was full
+} paramqueue;
+
+// room for capacity pending changes (rounded up to a power of two)
+int paramQueueInit(paramqueue *queue, size_t capacity);
+void paramQueueFree(paramqueue *queue);
+
+// control thread: 0 on success, -1 if the queue is full
+int paramQueueSend(paramqueue *queue, parameter param, float value);
+// audio thread: up to max pending changes in the order they were sent
+size_t paramQueueReceive(paramqueue *queue, paramchange *changes, size_t max);
+
+#endif  // PARAMQUEUE_H
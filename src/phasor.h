@@ -0,0 +1,50 @@
+/**
+ *  Purpose:
+ *    32-bit fixed point phase accumulator for wavetable oscillators
+ *
+ *  phasor.h
+ *
+ *  One full cycle of the waveform is 2^32. Adding the increment every
+ *  sample wraps for free through unsigned overflow, so there is no range
+ *  check and the pitch never drifts, however long the tone runs. For a
+ *  table of 2^bits points the top bits of the phase are the table index
+ *  and the remaining low bits the fraction between two points.
+ *
+ *  At 44.1 kHz the frequency resolution is 44100 / 2^32, about 10 uHz.
+ */
+
+#ifndef PHASOR_H
+#define PHASOR_H
+
+#include <math.h>
+#include <stdint.h>
+
+#define PHASOR_CYCLE (4294967296.)  // 2^32, one period
+
+// phase step per sample for frequency at sampleRate, negative frequencies
+// and frequencies above the sample rate fold back into one cycle
+static inline uint32_t phasorIncrement(double frequency, double sampleRate) {
+  double cycles = frequency / sampleRate;
+
+  cycles -= floor(cycles);
+  return (uint32_t)(uint64_t)llround(cycles * PHASOR_CYCLE);
+}
+
+// convert a phase given in cycles (0 to 1) to the fixed point phase
+static inline uint32_t phasorFromCycles(double cycles) {
+  cycles -= floor(cycles);
+  return (uint32_t)(uint64_t)llround(cycles * PHASOR_CYCLE);
+}
+
+// table index for a table of 2^tableBits points
+static inline uint32_t phasorIndex(uint32_t phase, int tableBits) {
+  return phase >> (32 - tableBits);
+}
+
+// fraction between index and index + 1, in [0, 1); only the top 24 bits
+// below the index are kept so the conversion to float is exact
+static inline float phasorFraction(uint32_t phase, int tableBits) {
+  return (float)((phase << tableBits) >> 8) * (1.f / 16777216.f);
+}
+
+#endif  // PHASOR_H
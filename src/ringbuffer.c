@@ -0,0 +1,95 @@
+/**
+ *  Purpose:
+ *    lock-free single producer / single consumer ring buffer, see ringbuffer.h
+ *
+ *  ringbuffer.c
+ */
+
+#include "ringbuffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int ringBufferInit(ringbuffer *rb, size_t elementSize, size_t capacity) {
+  size_t n = 1;
+
+  while (n < capacity) n <<= 1;
+  rb->data = malloc(n * elementSize);
+  if (rb->data == NULL) return -1;
+  rb->elementSize = elementSize;
+  rb->capacity = n;
+  rb->mask = n - 1;
+  atomic_init(&rb->writeIndex, 0);
+  atomic_init(&rb->readIndex, 0);
+
+  return 0;
+}
+
+void ringBufferFree(ringbuffer *rb) {
+  free(rb->data);
+  rb->data = NULL;
+}
+
+size_t ringBufferReadAvailable(ringbuffer *rb) {
+  return atomic_load_explicit(&rb->writeIndex, memory_order_acquire) -
+         atomic_load_explicit(&rb->readIndex, memory_order_relaxed);
+}
+
+size_t ringBufferWriteAvailable(ringbuffer *rb) {
+  return rb->capacity -
+         (atomic_load_explicit(&rb->writeIndex, memory_order_relaxed) -
+          atomic_load_explicit(&rb->readIndex, memory_order_acquire));
+}
+
+size_t ringBufferWrite(ringbuffer *rb, const void *elements, size_t count) {
+  size_t w = atomic_load_explicit(&rb->writeIndex, memory_order_relaxed);
+  size_t space = ringBufferWriteAvailable(rb);
+  size_t start, first;
+
+  if (count > space) count = space;
+  start = w & rb->mask;
+  first = rb->capacity - start;  // elements before the wrap point
+  if (first > count) first = count;
+  memcpy(rb->data + start * rb->elementSize, elements,
+         first * rb->elementSize);
+  memcpy(rb->data, (const char *)elements + first * rb->elementSize,
+         (count - first) * rb->elementSize);
+  atomic_store_explicit(&rb->writeIndex, w + count, memory_order_release);
+
+  return count;
+}
+
+size_t ringBufferRead(ringbuffer *rb, void *elements, size_t count) {
+  void *data1, *data2;
+  size_t size1, size2;
+
+  count = ringBufferGetReadRegions(rb, count, &data1, &size1, &data2, &size2);
+  memcpy(elements, data1, size1 * rb->elementSize);
+  memcpy((char *)elements + size1 * rb->elementSize, data2,
+         size2 * rb->elementSize);
+  ringBufferAdvanceRead(rb, count);
+
+  return count;
+}
+
+size_t ringBufferGetReadRegions(ringbuffer *rb, size_t count, void **data1,
+                                size_t *size1, void **data2, size_t *size2) {
+  size_t r = atomic_load_explicit(&rb->readIndex, memory_order_relaxed);
+  size_t available = ringBufferReadAvailable(rb);
+  size_t start = r & rb->mask;
+
+  if (count > available) count = available;
+  *size1 = rb->capacity - start;
+  if (*size1 > count) *size1 = count;
+  *data1 = rb->data + start * rb->elementSize;
+  *size2 = count - *size1;
+  *data2 = rb->data;
+
+  return count;
+}
+
+void ringBufferAdvanceRead(ringbuffer *rb, size_t count) {
+  size_t r = atomic_load_explicit(&rb->readIndex, memory_order_relaxed);
+
+  atomic_store_explicit(&rb->readIndex, r + count, memory_order_release);
+}
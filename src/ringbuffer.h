@@ -0,0 +1,44 @@
+/**
+ *  Purpose:
+ *    lock-free single producer / single consumer ring buffer
+ *
+ *  ringbuffer.h
+ *
+ *  Fixed size elements in a power of two sized array. One thread may write
+ *  and one other thread may read at the same time without locks; neither
+ *  side ever blocks or allocates, so the producer can be an audio callback.
+ *  The read and write counters run freely and are masked on access.
+ */
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+typedef struct {
+  char *data;
+  size_t elementSize;
+  size_t capacity;  // in elements, a power of two
+  size_t mask;
+  _Alignas(64) atomic_size_t writeIndex;  // owned by the producer
+  _Alignas(64) atomic_size_t readIndex;   // owned by the consumer
+} ringbuffer;
+
+// capacity is rounded up to a power of two, returns 0 on success
+int ringBufferInit(ringbuffer *rb, size_t elementSize, size_t capacity);
+void ringBufferFree(ringbuffer *rb);
+
+size_t ringBufferReadAvailable(ringbuffer *rb);
+size_t ringBufferWriteAvailable(ringbuffer *rb);
+// copy up to count elements in or out, returns the number copied
+size_t ringBufferWrite(ringbuffer *rb, const void *elements, size_t count);
+size_t ringBufferRead(ringbuffer *rb, void *elements, size_t count);
+
+// zero copy access for the consumer: up to two contiguous regions holding
+// at most count readable elements, released with ringBufferAdvanceRead
+size_t ringBufferGetReadRegions(ringbuffer *rb, size_t count, void **data1,
+                                size_t *size1, void **data2, size_t *size2);
+void ringBufferAdvanceRead(ringbuffer *rb, size_t count);
+
+#endif  // RINGBUFFER_H
@@ -0,0 +1,180 @@
+/**
+ *  Purpose:
+ *    real-time setup of the process, see rtsetup.h
+ *
+ *  rtsetup.c
+ *
+ *  Linux only: elsewhere rtSetup touches the stack and reports the rest
+ *  as not supported.
+ */
+
+#define _GNU_SOURCE
+
+#include "rtsetup.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <link.h>
+#include <sys/mman.h>
+#endif
+
+// page aligned range around bytes at data
+static void pageRange(const void *data, size_t bytes, uintptr_t *start,
+                      size_t *length) {
+  const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+  uintptr_t end = ((uintptr_t)data + bytes + page - 1) & ~(page - 1);
+
+  *start = (uintptr_t)data & ~(page - 1);
+  *length = end - *start;
+}
+
+void rtPrefault(rtstatus *rt, const void *data, size_t bytes) {
+  const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  const volatile char *p = (const volatile char *)data;
+  uintptr_t start;
+  size_t length, k;
+
+  if (data == NULL || bytes == 0) return;
+  pageRange(data, bytes, &start, &length);
+#if defined(__linux__)
+  // mlock populates the range, breaking copy on write where it is
+  // writable, which reading alone would not; after mlockall failed it
+  // would fail the same way, so the pages are only read
+  if (rt->lockError == 0) {
+    if (mlock((const void *)start, length) == 0) {
+      rt->prefaulted += length;
+      return;
+    }
+    if (rt->prefaultError == 0) rt->prefaultError = errno;
+  }
+#endif
+  for (k = 0; k < bytes; k += page) (void)p[k];
+  (void)p[bytes - 1];
+  rt->prefaulted += length;
+}
+
+// writes its own frame, so the stack below the caller is mapped
+static __attribute__((noinline)) void prefaultStack(rtstatus *rt) {
+  volatile char stack[RTSETUP_STACK_BYTES];
+  size_t k;
+
+  for (k = 0; k < sizeof(stack); k += 256) stack[k] = 0;
+  rt->prefaulted += sizeof(stack);
+}
+
+#if defined(__linux__)
+// dl_iterate_phdr callback: every loadable segment of one object
+static int prefaultObject(struct dl_phdr_info *info, size_t size,
+                          void *data) {
+  int k;
+
+  for (k = 0; k < info->dlpi_phnum; k++)
+    if (info->dlpi_phdr[k].p_type == PT_LOAD)
+      rtPrefault((rtstatus *)data,
+                 (const void *)(info->dlpi_addr + info->dlpi_phdr[k].p_vaddr),
+                 info->dlpi_phdr[k].p_memsz);
+  return 0;
+}
+#endif
+
+// "2-3,6" from sysfs into rt->isolated
+static void readIsolated(rtstatus *rt) {
+  char list[256], *p = list, *next;
+  FILE *file = fopen("/sys/devices/system/cpu/isolated", "r");
+  long first, last;
+
+  rt->isolatedCount = 0;
+  if (file == NULL) return;
+  if (fgets(list, sizeof(list), file) == NULL) list[0] = 0;
+  fclose(file);
+  while (*p >= '0' && *p <= '9') {
+    first = last = strtol(p, &next, 10);
+    if (*next == '-') last = strtol(next + 1, &next, 10);
+    for (; first <= last && rt->isolatedCount < RTSETUP_MAX_CPUS; first++)
+      rt->isolated[rt->isolatedCount++] = (int)first;
+    p = *next == ',' ? next + 1 : next;
+  }
+}
+
+int rtSetup(rtstatus *rt, workerpool *workers, int priority) {
+  struct sched_param param;
+  int i, error;
+
+  memset(rt, 0, sizeof(*rt));
+  rt->priority = priority;
+#if defined(__linux__) && defined(MCL_ONFAULT)
+  if (mlockall(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT) != 0)
+    rt->lockError = errno;
+  dl_iterate_phdr(prefaultObject, rt);
+#else
+  rt->lockError = ENOSYS;
+#endif
+  prefaultStack(rt);
+
+  readIsolated(rt);
+  if (workers != NULL) {
+    rt->workers = workers->threadCount;
+    if (rt->isolatedCount > 0)
+      rt->pinned =
+          workerPoolPin(workers, rt->isolated, rt->isolatedCount);
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    for (i = 0; i < workers->threadCount && rt->priorityError == 0; i++) {
+      error = pthread_setschedparam(workers->workers[i].thread, SCHED_FIFO,
+                                    &param);
+      if (error != 0) rt->priorityError = error;
+    }
+  }
+
+  return rt->lockError == 0 && rt->prefaultError == 0 &&
+                 rt->priorityError == 0
+             ? 0
+             : -1;
+}
+
+void rtSetupPrint(FILE *file, const rtstatus *rt) {
+  int i;
+
+  if (rt->lockError == 0)
+    fprintf(file, "Memory: locked, %.1f MB prefaulted\n",
+            rt->prefaulted / 1048576.);
+  else
+    fprintf(file,
+            "Memory: not locked (%s), %.1f MB prefaulted but may be paged "
+            "out; raise the memlock limit (ulimit -l, or memlock in "
+            "/etc/security/limits.conf)\n",
+            strerror(rt->lockError), rt->prefaulted / 1048576.);
+  if (rt->lockError == 0 && rt->prefaultError != 0)
+    fprintf(file,
+            "Memory: part of it not locked (%s), the memlock limit is "
+            "too low for the program and its tables\n",
+            strerror(rt->prefaultError));
+
+  if (rt->workers == 0) return;
+  if (rt->priorityError == 0)
+    fprintf(file, "Workers: %d threads at SCHED_FIFO %d\n", rt->workers,
+            rt->priority);
+  else
+    fprintf(file,
+            "Workers: %d threads left at normal priority, SCHED_FIFO %d "
+            "refused (%s); allow rtprio in /etc/security/limits.conf or "
+            "grant CAP_SYS_NICE\n",
+            rt->workers, rt->priority, strerror(rt->priorityError));
+  if (rt->isolatedCount == 0) {
+    fprintf(file,
+            "Workers: no isolated cores, sharing them with the rest of the "
+            "system (boot with isolcpus= to reserve some)\n");
+    return;
+  }
+  fprintf(file, "Workers: %d pinned to isolated cores", rt->pinned);
+  for (i = 0; i < rt->isolatedCount; i++)
+    fprintf(file, "%s%d", i == 0 ? " " : ",", rt->isolated[i]);
+  fprintf(file, "\n");
+}
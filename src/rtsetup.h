@@ -0,0 +1,59 @@
+/**
+ *  Purpose:
+ *    prepare the process for real-time audio before the stream starts
+ *
+ *  rtsetup.h
+ *
+ *  Page faults and preemption are the usual causes of xruns that the
+ *  callback itself cannot explain. rtSetup, run once before the stream is
+ *  opened:
+ *
+ *    - locks memory with mlockall, current and future mappings, locked as
+ *      they are first touched so a mapped wavetable bank of several GB
+ *      stays out of RAM apart from the tables that are played
+ *    - prefaults the code and static data of the program and its shared
+ *      libraries (the built-in tables among them) and RTSETUP_STACK_BYTES
+ *      of stack; the stacks of threads created afterwards, like
+ *      PortAudio's callback thread, stay locked once they are touched
+ *    - gives the workers of a workerpool SCHED_FIFO at the priority asked
+ *      for, and moves them onto the isolated cores (isolcpus=) if the
+ *      kernel has any
+ *
+ *  Any other memory the callback reads, the tables of a bank or buffers
+ *  from malloc, is prefaulted with rtPrefault. Missing permissions are not
+ *  fatal, everything that can be done is done; rtSetupPrint reports what
+ *  was refused and which limit to raise.
+ */
+
+#ifndef RTSETUP_H
+#define RTSETUP_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "workerpool.h"
+
+#define RTSETUP_STACK_BYTES (256 * 1024)
+#define RTSETUP_PRIORITY 70  // SCHED_FIFO, below typical audio servers
+#define RTSETUP_MAX_CPUS 64
+
+typedef struct {
+  int lockError;        // errno of mlockall, 0 when memory is locked
+  int prefaultError;    // errno of the first mlock refused, 0 if none
+  size_t prefaulted;    // bytes of code, data, stack and tables touched
+  int workers;          // worker threads of the pool
+  int priority;         // SCHED_FIFO priority asked for them
+  int priorityError;    // errno of pthread_setschedparam, 0 when granted
+  int isolated[RTSETUP_MAX_CPUS];  // from /sys/devices/system/cpu/isolated
+  int isolatedCount;
+  int pinned;           // workers moved onto isolated cores
+} rtstatus;
+
+// locks memory, prefaults the program and the stack and sets up the
+// workers (NULL for none) at priority; 0 when everything was granted
+int rtSetup(rtstatus *rt, workerpool *workers, int priority);
+// fault in and, if memory is locked, lock bytes at data
+void rtPrefault(rtstatus *rt, const void *data, size_t bytes);
+// what was done, and for what was not the limit or setting to change
+void rtSetupPrint(FILE *file, const rtstatus *rt);
+
+#endif  // RTSETUP_H
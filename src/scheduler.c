@@ -0,0 +1,152 @@
+/**
+ *  Purpose:
+ *    sample accurate event scheduling, see scheduler.h
+ *
+ *  scheduler.c
+ */
+
+#include "scheduler.h"
+
+int schedulerInit(scheduler *s, PaStreamCallback *callback, void *userData,
+                  eventHandler handler, int channelCount, double sampleRate) {
+  s->callback = callback;
+  s->userData = userData;
+  s->handler = handler;
+  s->channelCount = channelCount;
+  s->sampleRate = sampleRate;
+  s->sent = 0;
+  s->count = 0;
+  s->frame = 0;
+  atomic_init(&s->dropped, 0);
+  atomic_init(&s->anchorSequence, 0);
+  atomic_init(&s->anchorFrame, 0);
+  atomic_init(&s->anchorTime, 0.);
+  return ringBufferInit(&s->inbox, sizeof(event), SCHEDULER_MAX_EVENTS);
+}
+
+void schedulerFree(scheduler *s) { ringBufferFree(&s->inbox); }
+
+int schedulerSend(scheduler *s, const event *e) {
+  event copy = *e;
+
+  copy.sequence = s->sent++;
+  if (ringBufferWrite(&s->inbox, &copy, 1) == 1) return 0;
+  atomic_fetch_add_explicit(&s->dropped, 1, memory_order_relaxed);
+  return -1;
+}
+
+unsigned long long schedulerFrameAt(scheduler *s, PaTime time) {
+  unsigned int sequence;
+  unsigned long long frame;
+  double anchor, frames;
+
+  // retry while the callback is halfway through updating the anchor
+  do {
+    sequence = atomic_load_explicit(&s->anchorSequence, memory_order_acquire);
+    frame = atomic_load_explicit(&s->anchorFrame, memory_order_relaxed);
+    anchor = atomic_load_explicit(&s->anchorTime, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+  } while ((sequence & 1) != 0 ||
+           sequence != atomic_load_explicit(&s->anchorSequence,
+                                            memory_order_relaxed));
+
+  frames = (time - anchor) * s->sampleRate;
+  if (frames < 0. && -frames > frame) return 0;
+  return frame + (long long)(frames + (frames < 0. ? -.5 : .5));
+}
+
+static void publishAnchor(scheduler *s, PaTime time) {
+  unsigned int sequence =
+      atomic_load_explicit(&s->anchorSequence, memory_order_relaxed);
+
+  atomic_store_explicit(&s->anchorSequence, sequence + 1,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&s->anchorFrame, s->frame, memory_order_relaxed);
+  atomic_store_explicit(&s->anchorTime, time, memory_order_relaxed);
+  atomic_store_explicit(&s->anchorSequence, sequence + 2,
+                        memory_order_release);
+}
+
+// heap order: earlier frame first, then the order the events were sent
+static int before(const event *a, const event *b) {
+  return a->frame != b->frame ? a->frame < b->frame
+                              : a->sequence < b->sequence;
+}
+
+static void heapPush(scheduler *s, const event *e) {
+  int i = s->count++, parent;
+
+  while (i > 0) {
+    parent = (i - 1) / 2;
+    if (!before(e, &s->heap[parent])) break;
+    s->heap[i] = s->heap[parent];
+    i = parent;
+  }
+  s->heap[i] = *e;
+}
+
+static void heapPop(scheduler *s) {
+  const event last = s->heap[--s->count];
+  int i = 0, child;
+
+  while ((child = 2 * i + 1) < s->count) {
+    if (child + 1 < s->count && before(&s->heap[child + 1], &s->heap[child]))
+      child++;
+    if (!before(&s->heap[child], &last)) break;
+    s->heap[i] = s->heap[child];
+    i = child;
+  }
+  s->heap[i] = last;
+}
+
+// move everything sent since the last block into the heap
+static void receive(scheduler *s) {
+  event batch[SCHEDULER_BATCH];
+  size_t count, i;
+
+  do {
+    count = ringBufferRead(&s->inbox, batch, SCHEDULER_BATCH);
+    for (i = 0; i < count; i++) {
+      if (s->count < SCHEDULER_MAX_EVENTS)
+        heapPush(s, &batch[i]);
+      else
+        atomic_fetch_add_explicit(&s->dropped, 1, memory_order_relaxed);
+    }
+  } while (count == SCHEDULER_BATCH);
+}
+
+int schedulerCallback(const void *inputBuffer, void *outputBuffer,
+                      unsigned long framesPerBuffer,
+                      const PaStreamCallbackTimeInfo *timeInfo,
+                      PaStreamCallbackFlags statusFlags, void *userData) {
+  scheduler *s = (scheduler *)userData;
+  float *out = (float *)outputBuffer;
+  PaStreamCallbackTimeInfo pieceTime = *timeInfo;
+  unsigned long done = 0, n;
+  int result = paContinue, r;
+
+  receive(s);
+  publishAnchor(s, timeInfo->outputBufferDacTime);
+
+  while (done < framesPerBuffer) {
+    while (s->count > 0 && s->heap[0].frame <= s->frame) {
+      s->handler(&s->heap[0], s->userData);
+      heapPop(s);
+    }
+
+    // render up to the next event, or to the end of the block
+    n = framesPerBuffer - done;
+    if (s->count > 0 && s->heap[0].frame - s->frame < n)
+      n = (unsigned long)(s->heap[0].frame - s->frame);
+    pieceTime.outputBufferDacTime =
+        timeInfo->outputBufferDacTime + done / s->sampleRate;
+    r = s->callback(NULL, out + done * s->channelCount, n, &pieceTime,
+                    statusFlags, s->userData);
+    if (result == paContinue) result = r;
+    s->frame += n;
+    done += n;
+  }
+
+  return result;
+}
@@ -0,0 +1,86 @@
+/**
+ *  Purpose:
+ *    sample accurate event scheduling inside the audio callback
+ *
+ *  scheduler.h
+ *
+ *  Events (note on, note off, parameter changes) carry the absolute sample
+ *  frame at which they take effect, counted from the start of the stream.
+ *  A control thread sends them through a lock-free inbox; the callback
+ *  moves them into a binary min-heap it owns, so scheduling is O(log n)
+ *  with thousands of events pending, and nothing is allocated once the
+ *  scheduler is initialised.
+ *
+ *  schedulerCallback wraps the stream callback: it splits every block at
+ *  the frames where events are due, hands each event to the handler and
+ *  renders the pieces in between, so a change lands on its exact frame.
+ *  Events already late are applied at the start of the block. Streams are
+ *  output only: the pieces are rendered without an input buffer.
+ *
+ *  To place events in time the callback keeps the frame and the stream
+ *  time (timeInfo->outputBufferDacTime) of its last block, from which
+ *  schedulerFrameAt converts any stream time to a frame.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdatomic.h>
+#include "paramqueue.h"
+#include "portaudio.h"
+#include "ringbuffer.h"
+
+#define SCHEDULER_MAX_EVENTS 4096  // pending in the heap, and in the inbox
+#define SCHEDULER_BATCH 64         // events taken from the inbox at a time
+
+typedef enum { EVENT_NOTE_ON, EVENT_NOTE_OFF, EVENT_PARAM } eventtype;
+
+typedef struct {
+  unsigned long long frame;  // absolute sample time
+  unsigned long sequence;    // set by schedulerSend, orders equal frames
+  eventtype type;
+  int key;                   // note key for notes, else a parameter
+  float value;               // note frequency, or the parameter value
+  float amplitude;           // note on only
+} event;
+
+// applies one event to the synth, called from the audio thread
+typedef void (*eventHandler)(const event *e, void *userData);
+
+typedef struct {
+  PaStreamCallback *callback;  // renders the pieces between events
+  void *userData;              // for callback and handler
+  eventHandler handler;
+  int channelCount;            // interleaved float output
+  double sampleRate;
+
+  ringbuffer inbox;           // control thread to audio thread
+  unsigned long sent;         // owned by the control thread
+  atomic_ullong dropped;      // events lost to a full inbox or heap
+
+  event heap[SCHEDULER_MAX_EVENTS];  // owned by the audio thread
+  int count;
+  unsigned long long frame;   // frame of the next sample rendered
+
+  // stream time of the last block start, a seqlock for the control thread
+  atomic_uint anchorSequence;
+  atomic_ullong anchorFrame;
+  _Atomic double anchorTime;
+} scheduler;
+
+int schedulerInit(scheduler *s, PaStreamCallback *callback, void *userData,
+                  eventHandler handler, int channelCount, double sampleRate);
+void schedulerFree(scheduler *s);
+
+// control thread: 0 on success, -1 if the inbox is full
+int schedulerSend(scheduler *s, const event *e);
+// control thread: the frame played at stream time, see Pa_GetStreamTime
+unsigned long long schedulerFrameAt(scheduler *s, PaTime time);
+
+// PaStreamCallback with userData a scheduler *
+int schedulerCallback(const void *inputBuffer, void *outputBuffer,
+                      unsigned long framesPerBuffer,
+                      const PaStreamCallbackTimeInfo *timeInfo,
+                      PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // SCHEDULER_H
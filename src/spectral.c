@@ -0,0 +1,224 @@
+/**
+ *  Purpose:
+ *    inverse FFT oscillator bank, see spectral.h
+ *
+ *  spectral.c
+ *
+ *  Frames are built zero phase: sample 0 of the transform is the centre of
+ *  the frame, negative times wrap to the end. A partial of amplitude a,
+ *  bin b and phase p at the centre is
+ *
+ *    a w(n) cos(2 pi b n / N + p)
+ *
+ *  whose transform is a/2 e^(ip) K(k - b) plus its mirror image, with K
+ *  the (real, even) transform of the zero phase window, tabulated once.
+ *  Only the positive frequency half is built: the real part of its
+ *  inverse transform is half the frame, so the mirror costs nothing.
+ */
+
+#include "spectral.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "builtin.h"
+#include "phasor.h"
+
+#define TWOPI (6.283185307179586)
+
+// 4 term Blackman-Harris, -92 dB side lobes, main lobe of +-4 bins
+static const double blackmanHarris[4] = {0.35875, 0.48829, 0.14128,
+                                         0.01168};
+
+// zero phase window at n, peak at 0
+static double window(int n, int length) {
+  double x = TWOPI * n / length;
+
+  return blackmanHarris[0] + blackmanHarris[1] * cos(x) +
+         blackmanHarris[2] * cos(2. * x) + blackmanHarris[3] * cos(3. * x);
+}
+
+int spectralInit(spectralbank *s, int frameBits, int maxPartials,
+                 double sampleRate) {
+  const int points = SPECTRAL_KERNEL_POINTS;
+  double d, k;
+  int i, n, length;
+
+  memset(s, 0, sizeof(*s));
+  if (frameBits < 6 || frameBits > 16 || maxPartials < 1) return -1;
+  length = 1 << frameBits;
+  s->frameLength = length;
+  s->hop = length / SPECTRAL_OVERLAP;
+  s->sampleRate = sampleRate;
+  s->maxPartials = maxPartials;
+  s->readPosition = s->hop;  // the first render builds a frame
+
+  s->ratio = calloc(maxPartials, sizeof(float));
+  s->level = calloc(maxPartials, sizeof(float));
+  s->phase = calloc(maxPartials, sizeof(uint32_t));
+  s->increment = calloc(maxPartials, sizeof(uint32_t));
+  s->re = calloc(length, sizeof(double));
+  s->im = calloc(length, sizeof(double));
+  s->sum = calloc(length, sizeof(float));
+  if (s->ratio == NULL || s->level == NULL || s->phase == NULL ||
+      s->increment == NULL || s->re == NULL || s->im == NULL ||
+      s->sum == NULL || fftInit(&s->plan, frameBits) != 0) {
+    spectralFree(s);
+    return -1;
+  }
+
+  // K(d) = sum over the frame of w(n) e^(-2 pi i d n / N), real but for
+  // the lone sample at -N/2, where the window is nearly 0
+  for (i = 0; i < points; i++) {
+    d = (double)i / SPECTRAL_OVERSAMPLE - SPECTRAL_LOBE;
+    k = window(0, length) + window(length / 2, length) * cos(TWOPI * d / 2);
+    for (n = 1; n < length / 2; n++)
+      k += 2. * window(n, length) * cos(TWOPI * d * n / length);
+    s->kernel[i] = k;
+  }
+  // the rest stays 0, for the taps past the last point
+  return 0;
+}
+
+void spectralFree(spectralbank *s) {
+  free(s->ratio);
+  free(s->level);
+  free(s->phase);
+  free(s->increment);
+  free(s->re);
+  free(s->im);
+  free(s->sum);
+  fftFree(&s->plan);
+  s->ratio = s->level = s->sum = NULL;
+  s->re = s->im = NULL;
+  s->phase = s->increment = NULL;
+}
+
+int spectralSetPartial(spectralbank *s, int index, float ratio, float level) {
+  if (index < 0 || index >= s->maxPartials) return -1;
+  s->ratio[index] = ratio;
+  s->level[index] = level;
+  if (index >= s->count) s->count = index + 1;
+  s->increment[index] =
+      phasorIncrement(s->frequency * ratio, s->sampleRate) * s->hop;
+  return 0;
+}
+
+void spectralSetFrequency(spectralbank *s, float frequency) {
+  int p;
+
+  s->frequency = frequency;
+  for (p = 0; p < s->count; p++)
+    s->increment[p] =
+        phasorIncrement(frequency * s->ratio[p], s->sampleRate) * s->hop;
+}
+
+// cos and sin of phase from the built-in sine table
+static inline void rotor(uint32_t phase, double *c, double *s) {
+  const float *table = builtinSine();
+  uint32_t i = phasorIndex(phase, BUILTIN_TABLE_BITS);
+  float x = phasorFraction(phase, BUILTIN_TABLE_BITS);
+  uint32_t j = phasorIndex(phase + 0x40000000u, BUILTIN_TABLE_BITS);
+
+  *s = table[i] + x * (table[i + 1] - table[i]);
+  *c = table[j] + x * (table[j + 1] - table[j]);
+}
+
+// spectrum of every partial, inverse transform, overlap-add into sum
+static void synthesize(spectralbank *s) {
+  const int length = s->frameLength, mask = length - 1;
+  const double binsPerHz = length / s->sampleRate;
+  const double nyquist = length / 2 - SPECTRAL_LOBE;
+  // the overlapping windows sum to SPECTRAL_OVERLAP * a0, and the real
+  // part of the half spectrum is half the signal
+  const double gain = 2. / (SPECTRAL_OVERLAP * blackmanHarris[0]);
+  const double *taps;
+  double b, a, cr, ci, x, kv;
+  int p, j, k, bin, n;
+
+  memset(s->re, 0, length * sizeof(double));
+  memset(s->im, 0, length * sizeof(double));
+  for (p = 0; p < s->count; p++) {
+    b = s->frequency * s->ratio[p] * binsPerHz;
+    a = .5 * s->amplitude * s->level[p];
+    // culled above Nyquist, the lobe would fold back over it
+    if (b > 0. && b < nyquist && a != 0.) {
+      rotor(s->phase[p], &cr, &ci);
+      cr *= a;
+      ci *= a;
+      // the bins k - b of the lobe are a bin apart, so they all share
+      // one interpolation fraction and lie SPECTRAL_OVERSAMPLE points
+      // apart in the table
+      k = (int)b - SPECTRAL_LOBE + 1;
+      x = (k - b + SPECTRAL_LOBE) * SPECTRAL_OVERSAMPLE;
+      taps = s->kernel + (int)x;
+      x -= (int)x;
+      for (j = 0; j <= 2 * SPECTRAL_LOBE; j++, k++) {
+        kv = taps[0] + x * (taps[1] - taps[0]);
+        taps += SPECTRAL_OVERSAMPLE;
+        bin = k & mask;  // below 0 wraps to the negative frequencies
+        s->re[bin] += cr * kv;
+        s->im[bin] += ci * kv;
+      }
+    }
+    // on to the centre of the next frame, a hop later
+    s->phase[p] += s->increment[p];
+  }
+  fftInverse(&s->plan, s->re, s->im);
+
+  // the frame centre is sample 0 of the transform and lands mid frame
+  for (n = 0; n < length; n++)
+    s->sum[n] += (float)(gain * s->re[(n - length / 2) & mask]);
+}
+
+void spectralRender(spectralbank *s, float *out, unsigned long frames) {
+  unsigned long i, n;
+
+  while (frames > 0) {
+    if (s->readPosition == s->hop) {
+      // the first hop is complete, slide the sum and add the next frame
+      memmove(s->sum, s->sum + s->hop,
+              (s->frameLength - s->hop) * sizeof(float));
+      memset(s->sum + s->frameLength - s->hop, 0, s->hop * sizeof(float));
+      synthesize(s);
+      s->readPosition = 0;
+    }
+    n = (unsigned long)(s->hop - s->readPosition);
+    if (n > frames) n = frames;
+    for (i = 0; i < n; i++) {
+      *out++ = s->sum[s->readPosition + i];  // left channel
+      *out++ = s->sum[s->readPosition + i];  // right channel
+    }
+    s->readPosition += (int)n;
+    frames -= n;
+  }
+}
+
+void spectralEventHandler(const event *e, void *userData) {
+  spectralbank *s = (spectralbank *)userData;
+
+  switch (e->type) {
+    case EVENT_NOTE_ON:
+      spectralSetFrequency(s, e->value);
+      s->amplitude = e->amplitude;
+      break;
+    case EVENT_NOTE_OFF:
+      s->amplitude = 0.f;
+      break;
+    case EVENT_PARAM:
+      if (e->key == PARAM_FREQUENCY)
+        spectralSetFrequency(s, e->value);
+      else if (e->key == PARAM_AMPLITUDE)
+        s->amplitude = e->value;
+      break;
+  }
+}
+
+int spectralCallback(const void *inputBuffer, void *outputBuffer,
+                     unsigned long framesPerBuffer,
+                     const PaStreamCallbackTimeInfo *timeInfo,
+                     PaStreamCallbackFlags statusFlags, void *userData) {
+  spectralRender((spectralbank *)userData, (float *)outputBuffer,
+                 framesPerBuffer);
+  return paContinue;
+}
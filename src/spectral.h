@@ -0,0 +1,84 @@
+/**
+ *  Purpose:
+ *    inverse FFT oscillator bank for very many partials
+ *
+ *  spectral.h
+ *
+ *  Plays one note as a sum of partials, like additive.h, but builds every
+ *  frame in the frequency domain: each partial adds the spectrum of a
+ *  windowed sinusoid, the transform of a 4 term Blackman-Harris window
+ *  centred on its fractional bin, to a few bins on either side. One
+ *  inverse FFT (fft.h) per hop turns the spectrum into a windowed frame
+ *  of all the partials at once, and the frames overlap-add, a quarter of a
+ *  frame apart, into a continuous signal.
+ *
+ *  A partial costs one table lookup and nine complex multiply-adds per
+ *  hop instead of work on every sample, and the transform costs the same
+ *  however many partials there are, so tens of thousands of sinusoids
+ *  render at a nearly fixed cost per block. Cutting the window spectrum
+ *  off at its main lobe leaves errors around -80 dB. Frequency and
+ *  amplitude changes take effect at the next frame, crossfaded by the
+ *  overlap, and the output starts with a fade in of one frame.
+ *
+ *  spectralInit allocates; rendering and the setters never do.
+ */
+
+#ifndef SPECTRAL_H
+#define SPECTRAL_H
+
+#include <stdint.h>
+#include "fft.h"
+#include "portaudio.h"
+#include "scheduler.h"
+
+#define SPECTRAL_FRAME_BITS 10   // default frame of 1024 points
+#define SPECTRAL_OVERLAP 4       // frames overlapping at every sample
+#define SPECTRAL_LOBE 4          // bins of the window spectrum either side
+#define SPECTRAL_OVERSAMPLE 256  // kernel table points per bin
+#define SPECTRAL_KERNEL_POINTS (2 * SPECTRAL_LOBE * SPECTRAL_OVERSAMPLE + 1)
+
+typedef struct {
+  fft plan;
+  int frameLength;
+  int hop;
+  double sampleRate;
+
+  float frequency;  // of the note, partials are ratios of it
+  float amplitude;
+  // per partial, [0, count) are playing
+  float *ratio;
+  float *level;
+  uint32_t *phase;      // phasor.h phase at the centre of the next frame
+  uint32_t *increment;  // phase step of one hop
+  int count;
+  int maxPartials;
+
+  // window spectrum from -SPECTRAL_LOBE to SPECTRAL_LOBE bins, then a bin
+  // of zeros for the last tap of the lobe
+  double kernel[SPECTRAL_KERNEL_POINTS + SPECTRAL_OVERSAMPLE + 1];
+  double *re, *im;   // spectrum, then frame, of frameLength points
+  float *sum;        // overlap-add of the frames, frameLength points
+  int readPosition;  // next output sample in sum, a new frame at hop
+} spectralbank;
+
+// returns 0 on success
+int spectralInit(spectralbank *s, int frameBits, int maxPartials,
+                 double sampleRate);
+void spectralFree(spectralbank *s);
+// sets partial index (count grows to include it), -1 if out of range
+int spectralSetPartial(spectralbank *s, int index, float ratio, float level);
+void spectralSetFrequency(spectralbank *s, float frequency);
+// render interleaved stereo
+void spectralRender(spectralbank *s, float *out, unsigned long frames);
+
+// eventHandler: note on sets frequency and amplitude, note off silences,
+// PARAM_FREQUENCY and PARAM_AMPLITUDE are applied
+void spectralEventHandler(const event *e, void *userData);
+
+// PaStreamCallback rendering the spectralbank passed as userData
+int spectralCallback(const void *inputBuffer, void *outputBuffer,
+                     unsigned long framesPerBuffer,
+                     const PaStreamCallbackTimeInfo *timeInfo,
+                     PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // SPECTRAL_H
@@ -0,0 +1,178 @@
+/**
+ *  Purpose:
+ *    unison stack of detuned, panned oscillators, see unison.h
+ *
+ *  unison.c
+ */
+
+#include "unison.h"
+
+#include <math.h>
+#include <string.h>
+#include "phasor.h"
+#include "wavetable.h"
+
+#define QUARTER_PI (0.7853981633974483)
+
+void unisonInit(unisonwave *u, const float *wavetable, int tableBits,
+                int copies, float frequency, float amplitude,
+                double sampleRate) {
+  memset(u, 0, sizeof(*u));
+  if (copies < 2) copies = 2;
+  if (copies > OSC_UNISON_MAX) copies = OSC_UNISON_MAX;
+  u->wavetable = wavetable;
+  u->tableBits = tableBits;
+  u->copies = copies;
+  u->lanes = (copies + 7) & ~7;
+  u->frequency = frequency;
+  u->amplitude = amplitude;
+  u->targetAmplitude = amplitude;
+  u->rampFrames = (unsigned long)(WAVE_RAMP_SECONDS * sampleRate + .5);
+  u->rampLeft = 0;
+  u->sampleRate = sampleRate;
+  u->kernel = oscKernelBest();
+  u->seed = 1;
+  unisonSetSpread(u, UNISON_DETUNE, UNISON_SPREAD);
+  unisonRetrigger(u);
+}
+
+// where copy c sits in the stack, -1 to 1
+static double unisonOffset(const unisonwave *u, int c) {
+  return 2. * c / (u->copies - 1) - 1.;
+}
+
+void unisonSetFrequency(unisonwave *u, float frequency) {
+  int c;
+
+  u->frequency = frequency;
+  for (c = 0; c < u->copies; c++)
+    u->increment[c] = phasorIncrement(
+        frequency * pow(2., u->detune * .5 * unisonOffset(u, c) / 1200.),
+        u->sampleRate);
+}
+
+// the gains of every copy at the current amplitude
+static void scaleGains(unisonwave *u) {
+  int c;
+
+  for (c = 0; c < u->copies; c++) {
+    u->left[c] = u->amplitude * u->unitLeft[c];
+    u->right[c] = u->amplitude * u->unitRight[c];
+  }
+}
+
+// the equal power pans of the copies at amplitude 1, then the gains
+static void setPans(unisonwave *u) {
+  const double gain = 1. / sqrt((double)u->copies);
+  double pan;
+  int c, pair;
+
+  for (c = 0; c < u->copies; c++) {
+    // copy c and its mirror copies - 1 - c sit at opposite pans, and the
+    // side flips from one pair to the next, so neighbouring pitches part
+    // and the stack stays balanced for any count
+    pair = c < u->copies - 1 - c ? c : u->copies - 1 - c;
+    pan = u->spread * unisonOffset(u, c) * (pair % 2 == 0 ? 1. : -1.);
+    u->unitLeft[c] = (float)(gain * cos((pan + 1.) * QUARTER_PI));
+    u->unitRight[c] = (float)(gain * sin((pan + 1.) * QUARTER_PI));
+  }
+  scaleGains(u);
+}
+
+void unisonSetAmplitude(unisonwave *u, float amplitude) {
+  u->amplitude = u->targetAmplitude = amplitude;
+  u->rampLeft = 0;
+  scaleGains(u);
+}
+
+void unisonRampAmplitude(unisonwave *u, float amplitude) {
+  u->targetAmplitude = amplitude;
+  u->rampLeft = u->rampFrames;
+  if (u->rampLeft == 0) unisonSetAmplitude(u, amplitude);
+}
+
+void unisonSetSpread(unisonwave *u, float detune, float spread) {
+  u->detune = detune;
+  u->spread = spread;
+  unisonSetFrequency(u, u->frequency);
+  setPans(u);
+}
+
+void unisonRetrigger(unisonwave *u) {
+  int c;
+
+  for (c = 0; c < u->copies; c++) {
+    u->seed = u->seed * 1103515245ul + 12345ul;
+    u->phase[c] = (uint32_t)(u->seed >> 8) << 8;
+  }
+}
+
+// scale a piece rendered at amplitude 1 by the amplitude ramp, the gain
+// of frame i in closed form
+static void rampPiece(unisonwave *u, float *out, unsigned long frames) {
+  const float amp = u->amplitude;
+  const float step = (u->targetAmplitude - amp) / u->rampLeft;
+  unsigned long i;
+  float g;
+
+  for (i = 0; i < frames; i++) {
+    g = amp + (float)i * step;
+    out[2 * i] *= g;
+    out[2 * i + 1] *= g;
+  }
+  u->rampLeft -= frames;
+  u->amplitude = u->rampLeft == 0 ? u->targetAmplitude
+                                  : amp + (float)frames * step;
+  if (u->rampLeft == 0) scaleGains(u);
+}
+
+void unisonRender(unisonwave *u, float *out, unsigned long frames) {
+  const float *table = u->wavetable;
+  unsigned long n;
+
+  // the sharpest copy picks the level, so none of them aliases
+  if (u->bandlimited != NULL)
+    table = mipmapSelect(u->bandlimited, u->increment[u->copies - 1]);
+  if (u->rampLeft > 0) {
+    n = frames < u->rampLeft ? frames : u->rampLeft;
+    u->kernel->unison(table, u->tableBits, u->phase, u->increment,
+                      u->unitLeft, u->unitRight, u->lanes, out, n);
+    rampPiece(u, out, n);
+    out += 2 * n;
+    frames -= n;
+  }
+  if (frames > 0)
+    u->kernel->unison(table, u->tableBits, u->phase, u->increment, u->left,
+                      u->right, u->lanes, out, frames);
+}
+
+void unisonEventHandler(const event *e, void *userData) {
+  unisonwave *u = (unisonwave *)userData;
+
+  switch (e->type) {
+    case EVENT_NOTE_ON:
+      // new phases would jump copies still sounding
+      if (u->amplitude == 0.f && u->rampLeft == 0) unisonRetrigger(u);
+      unisonSetFrequency(u, e->value);
+      unisonRampAmplitude(u, e->amplitude);
+      break;
+    case EVENT_NOTE_OFF:
+      unisonRampAmplitude(u, 0.f);
+      break;
+    case EVENT_PARAM:
+      if (e->key == PARAM_FREQUENCY)
+        unisonSetFrequency(u, e->value);
+      else if (e->key == PARAM_AMPLITUDE)
+        unisonRampAmplitude(u, e->value);
+      break;
+  }
+}
+
+int unisonCallback(const void *inputBuffer, void *outputBuffer,
+                   unsigned long framesPerBuffer,
+                   const PaStreamCallbackTimeInfo *timeInfo,
+                   PaStreamCallbackFlags statusFlags, void *userData) {
+  unisonRender((unisonwave *)userData, (float *)outputBuffer,
+               framesPerBuffer);
+  return paContinue;
+}
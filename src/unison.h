@@ -0,0 +1,89 @@
+/**
+ *  Purpose:
+ *    unison (supersaw) stack of detuned, panned wavetable oscillators
+ *
+ *  unison.h
+ *
+ *  A unison wave plays one note as 2 to OSC_UNISON_MAX copies of the
+ *  same table. Their pitches are spread evenly over detune cents around
+ *  the note and their pans over the stereo field, alternating sides so
+ *  neighbouring pitches land apart. Every copy starts at its own pseudo
+ *  random phase, so a new note does not begin with all copies in step.
+ *
+ *  The copies are rendered together by the unison variant of the kernels
+ *  of osckernel.h, one copy per SIMD lane, each with an equal power left
+ *  and right gain summed straight into the interleaved output. The lane
+ *  count is rounded up to a multiple of 8 with silent copies.
+ *
+ *  Notes and amplitude events glide over WAVE_RAMP_SECONDS, as in
+ *  morph.h: the ramp is rendered with the gains at amplitude 1 and scaled
+ *  by the closed form ramp, so the kernel stays the same. A note only
+ *  picks new start phases when the stack is silent; one played over a
+ *  release keeps the copies running.
+ */
+
+#ifndef UNISON_H
+#define UNISON_H
+
+#include <stdint.h>
+#include "mipmap.h"
+#include "osckernel.h"
+#include "portaudio.h"
+#include "scheduler.h"
+
+#define UNISON_DETUNE (25.f)  // default spread, cents from lowest to highest
+#define UNISON_SPREAD (1.f)   // default stereo width, 0 mono to 1 full
+
+typedef struct {
+  const float *wavetable;     // 2^tableBits points plus a guard point
+  const mipmap *bandlimited;  // optional, replaces wavetable per block
+  int tableBits;
+  int copies;
+  float frequency;
+  float amplitude;
+  float detune;  // cents from the lowest copy to the highest
+  float spread;  // stereo width, 0 to 1
+  float targetAmplitude;  // amplitude glides towards while rampLeft > 0
+  unsigned long rampFrames;  // ramp time, 0 makes every change a jump
+  unsigned long rampLeft;    // frames until targetAmplitude is reached
+  double sampleRate;
+  const osckernel *kernel;
+  unsigned long seed;  // start phases of the next note
+
+  // per copy, lanes [copies, lanes) are silent padding
+  int lanes;
+  uint32_t phase[OSC_UNISON_MAX];
+  uint32_t increment[OSC_UNISON_MAX];
+  float left[OSC_UNISON_MAX];   // gains at amplitude
+  float right[OSC_UNISON_MAX];
+  float unitLeft[OSC_UNISON_MAX];  // gains at amplitude 1, for ramps
+  float unitRight[OSC_UNISON_MAX];
+} unisonwave;
+
+// copies is clamped to 2..OSC_UNISON_MAX
+void unisonInit(unisonwave *u, const float *wavetable, int tableBits,
+                int copies, float frequency, float amplitude,
+                double sampleRate);
+void unisonSetFrequency(unisonwave *u, float frequency);
+// jump to the amplitude at once, for setup code
+void unisonSetAmplitude(unisonwave *u, float amplitude);
+// glide from the current amplitude to a new one, restarting the ramp
+void unisonRampAmplitude(unisonwave *u, float amplitude);
+void unisonSetSpread(unisonwave *u, float detune, float spread);
+// new start phases for every copy, as for a new note
+void unisonRetrigger(unisonwave *u);
+// render interleaved stereo
+void unisonRender(unisonwave *u, float *out, unsigned long frames);
+
+// eventHandler: note on jumps to the frequency, retriggers a silent stack
+// and ramps up the amplitude, note off ramps it down to 0, PARAM_FREQUENCY
+// and PARAM_AMPLITUDE (ramped) are applied
+void unisonEventHandler(const event *e, void *userData);
+
+// PaStreamCallback rendering the unisonwave passed as userData
+int unisonCallback(const void *inputBuffer, void *outputBuffer,
+                   unsigned long framesPerBuffer,
+                   const PaStreamCallbackTimeInfo *timeInfo,
+                   PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // UNISON_H
@@ -0,0 +1,215 @@
+/**
+ *  Purpose:
+ *    polyphonic voice pool, see voicepool.h
+ *
+ *  voicepool.c
+ */
+
+#include "voicepool.h"
+
+#include <string.h>
+#include "phasor.h"
+
+void voicePoolInit(voicepool *pool, const float *wavetable, int tableBits,
+                   double sampleRate, int maxVoices) {
+  memset(pool, 0, sizeof(*pool));
+  if (maxVoices < 1 || maxVoices > VOICEPOOL_MAX_VOICES)
+    maxVoices = VOICEPOOL_MAX_VOICES;
+  pool->maxVoices = maxVoices;
+  pool->wavetable = wavetable;
+  pool->tableBits = tableBits;
+  pool->sampleRate = sampleRate;
+  pool->gain = 1.f;
+  pool->releaseFrames =
+      (unsigned long)(VOICEPOOL_RELEASE_SECONDS * sampleRate + .5);
+  if (pool->releaseFrames == 0) pool->releaseFrames = 1;
+}
+
+static int findVoice(const voicepool *pool, int id) {
+  int v;
+
+  for (v = 0; v < pool->activeCount; v++)
+    if (pool->id[v] == id) return v;
+  return -1;
+}
+
+// move the last active voice into slot v, keeping the arrays dense
+static void removeVoice(voicepool *pool, int v) {
+  int last = --pool->activeCount;
+
+  pool->frequency[v] = pool->frequency[last];
+  pool->amplitude[v] = pool->amplitude[last];
+  pool->phase[v] = pool->phase[last];
+  pool->increment[v] = pool->increment[last];
+  pool->ampStep[v] = pool->ampStep[last];
+  pool->releaseLeft[v] = pool->releaseLeft[last];
+  pool->started[v] = pool->started[last];
+  pool->id[v] = pool->id[last];
+  pool->key[v] = pool->key[last];
+}
+
+int voicePoolNoteOn(voicepool *pool, float frequency, float amplitude) {
+  return voicePoolNoteOnKey(pool, -1, frequency, amplitude);
+}
+
+int voicePoolNoteOnKey(voicepool *pool, int key, float frequency,
+                       float amplitude) {
+  int v, steal;
+
+  if (pool->activeCount < pool->maxVoices) {
+    v = pool->activeCount++;
+  } else {
+    // steal the voice closest to the end of its release, or if none is
+    // releasing the one that has been playing longest
+    steal = 0;
+    for (v = 1; v < pool->activeCount; v++)
+      if (pool->releaseLeft[v] != pool->releaseLeft[steal]
+              ? pool->releaseLeft[v] < pool->releaseLeft[steal]
+              : pool->started[v] < pool->started[steal])
+        steal = v;
+    v = steal;
+  }
+
+  pool->frequency[v] = frequency;
+  pool->amplitude[v] = amplitude;
+  pool->phase[v] = 0;
+  pool->increment[v] = phasorIncrement(frequency, pool->sampleRate);
+  pool->ampStep[v] = 0.f;
+  pool->releaseLeft[v] = VOICEPOOL_HELD;
+  pool->started[v] = pool->notes;
+  pool->id[v] = (int)(pool->notes & INT_MAX);
+  pool->key[v] = key;
+  pool->notes++;
+
+  return pool->id[v];
+}
+
+// start the fade out of a held voice
+static void releaseVoice(voicepool *pool, int v) {
+  if (pool->releaseLeft[v] != VOICEPOOL_HELD) return;  // already releasing
+  pool->releaseLeft[v] = pool->releaseFrames;
+  pool->ampStep[v] = -pool->amplitude[v] / pool->releaseFrames;
+}
+
+void voicePoolNoteOff(voicepool *pool, int id) {
+  int v = findVoice(pool, id);
+
+  if (v >= 0) releaseVoice(pool, v);
+}
+
+void voicePoolNoteOffKey(voicepool *pool, int key) {
+  int v;
+
+  if (key < 0) return;  // voices started without a key
+  for (v = 0; v < pool->activeCount; v++)
+    if (pool->key[v] == key) releaseVoice(pool, v);
+}
+
+void voicePoolSetFrequency(voicepool *pool, int id, float frequency) {
+  int v = findVoice(pool, id);
+
+  if (v < 0) return;
+  pool->frequency[v] = frequency;
+  pool->increment[v] = phasorIncrement(frequency, pool->sampleRate);
+}
+
+// workertask: mix group g of the voices over the chunk into its mix row
+static void renderGroup(void *data, int g) {
+  voicepool *pool = (voicepool *)data;
+  const float *table = pool->wavetable;
+  const mipmap *bandlimited = pool->bandlimited;
+  const int bits = pool->tableBits;
+  const unsigned long n = pool->chunkFrames;
+  const int end = (g + 1) * VOICEPOOL_GROUP < pool->activeCount
+                      ? (g + 1) * VOICEPOOL_GROUP
+                      : pool->activeCount;
+  float *mix = pool->mix[g];
+  unsigned long i, m;
+  uint32_t p, inc, index;
+  float amp, step, f, y0;
+  int v;
+
+  memset(mix, 0, n * sizeof(float));
+  // one voice at a time over the chunk, its state stays in registers
+  for (v = g * VOICEPOOL_GROUP; v < end; v++) {
+    p = pool->phase[v];
+    inc = pool->increment[v];
+    amp = pool->amplitude[v];
+    step = pool->ampStep[v];
+    if (bandlimited != NULL) table = mipmapSelect(bandlimited, inc);
+    if (pool->releaseLeft[v] == VOICEPOOL_HELD) {
+      for (i = 0; i < n; i++) {
+        index = phasorIndex(p, bits);
+        f = phasorFraction(p, bits);
+        y0 = table[index];
+        mix[i] += amp * (y0 + f * (table[index + 1] - y0));
+        p += inc;
+      }
+    } else {
+      // releasing: the gain of sample i in closed form, up to the end of
+      // the ramp, silent after it
+      m = n < pool->releaseLeft[v] ? n : pool->releaseLeft[v];
+      for (i = 0; i < m; i++) {
+        index = phasorIndex(p, bits);
+        f = phasorFraction(p, bits);
+        y0 = table[index];
+        mix[i] += (amp + (float)i * step) * (y0 + f * (table[index + 1] - y0));
+        p += inc;
+      }
+      pool->amplitude[v] = amp + (float)m * step;
+      pool->releaseLeft[v] -= m;
+    }
+    pool->phase[v] = p;
+  }
+}
+
+void voicePoolRender(voicepool *pool, float *out, unsigned long frames) {
+  float *mix = pool->mix[0];
+  unsigned long i, n;
+  int groups, g, v;
+
+  while (frames > 0) {
+    n = frames < VOICEPOOL_CHUNK ? frames : VOICEPOOL_CHUNK;
+    groups = (pool->activeCount + VOICEPOOL_GROUP - 1) / VOICEPOOL_GROUP;
+    pool->chunkFrames = n;
+    if (pool->workers != NULL)
+      workerPoolRun(pool->workers, renderGroup, pool, groups);
+    else
+      for (g = 0; g < groups; g++) renderGroup(pool, g);
+
+    // the groups in order into the first, whichever thread rendered them
+    if (groups == 0) memset(mix, 0, n * sizeof(float));
+    for (g = 1; g < groups; g++)
+      for (i = 0; i < n; i++) mix[i] += pool->mix[g][i];
+    for (i = 0; i < n; i++) {
+      *out++ = pool->gain * mix[i];  // left channel
+      *out++ = pool->gain * mix[i];  // right channel
+    }
+    frames -= n;
+
+    // free the voices that have faded out, once no worker reads them
+    for (v = 0; v < pool->activeCount;)
+      if (pool->releaseLeft[v] == 0)
+        removeVoice(pool, v);
+      else
+        v++;
+  }
+}
+
+void voicePoolEventHandler(const event *e, void *userData) {
+  voicepool *pool = (voicepool *)userData;
+
+  if (e->type == EVENT_NOTE_ON)
+    voicePoolNoteOnKey(pool, e->key, e->value, e->amplitude);
+  else if (e->type == EVENT_NOTE_OFF)
+    voicePoolNoteOffKey(pool, e->key);
+}
+
+int voicePoolCallback(const void *inputBuffer, void *outputBuffer,
+                      unsigned long framesPerBuffer,
+                      const PaStreamCallbackTimeInfo *timeInfo,
+                      PaStreamCallbackFlags statusFlags, void *userData) {
+  voicePoolRender((voicepool *)userData, (float *)outputBuffer,
+                  framesPerBuffer);
+  return paContinue;
+}
@@ -0,0 +1,98 @@
+/**
+ *  Purpose:
+ *    polyphonic voice pool built from many phasor wavetable oscillators
+ *
+ *  voicepool.h
+ *
+ *  Instead of one `wave` per stream, the pool keeps up to
+ *  VOICEPOOL_MAX_VOICES voices as a structure of arrays: frequency[],
+ *  amplitude[], phase[] and increment[] are contiguous and the active voices
+ *  are packed at the front, so rendering walks dense arrays with no holes.
+ *  Every active voice is rendered per block. The voices are mixed in
+ *  groups of VOICEPOOL_GROUP, and the groups are summed in order; with a
+ *  workerpool the groups are rendered on several cores, and the output is
+ *  bit identical to rendering them all on one.
+ *
+ *  A note off does not cut the voice, which would click: its amplitude
+ *  ramps to 0 over VOICEPOOL_RELEASE_SECONDS, with the gain of each sample
+ *  computed in closed form as in the ramps of wavetable.h, and the voice is
+ *  freed when the ramp ends.
+ *
+ *  All storage is inside the struct. Starting a note when the pool is full
+ *  steals a voice that is already releasing, or else the oldest, so
+ *  noteOn/noteOff never allocate and can be called from the audio
+ *  callback. The pool itself is not thread safe.
+ */
+
+#ifndef VOICEPOOL_H
+#define VOICEPOOL_H
+
+#include <limits.h>
+#include <stdint.h>
+#include "mipmap.h"
+#include "portaudio.h"
+#include "scheduler.h"
+#include "workerpool.h"
+
+#define VOICEPOOL_MAX_VOICES 512
+#define VOICEPOOL_CHUNK 256  // frames mixed at a time
+#define VOICEPOOL_GROUP 16   // voices per task of a workerpool
+#define VOICEPOOL_GROUPS (VOICEPOOL_MAX_VOICES / VOICEPOOL_GROUP)
+#define VOICEPOOL_RELEASE_SECONDS (0.005)  // fade out after a note off
+#define VOICEPOOL_HELD ULONG_MAX           // releaseLeft until the note off
+
+typedef struct {
+  // per voice state, slots [0, activeCount) are playing
+  float frequency[VOICEPOOL_MAX_VOICES];
+  float amplitude[VOICEPOOL_MAX_VOICES];
+  uint32_t phase[VOICEPOOL_MAX_VOICES];
+  uint32_t increment[VOICEPOOL_MAX_VOICES];
+  float ampStep[VOICEPOOL_MAX_VOICES];          // per sample, 0 while held
+  unsigned long releaseLeft[VOICEPOOL_MAX_VOICES];  // frames until freed
+  unsigned long started[VOICEPOOL_MAX_VOICES];  // note counter at noteOn
+  int id[VOICEPOOL_MAX_VOICES];                 // handle given to the caller
+  int key[VOICEPOOL_MAX_VOICES];                // caller's note key, or -1
+  int activeCount;
+  int maxVoices;
+
+  const float *wavetable;     // 2^tableBits points plus a guard point
+  const mipmap *bandlimited;  // optional, replaces wavetable per voice
+  workerpool *workers;        // optional, renders the groups in parallel
+  int tableBits;
+  double sampleRate;
+  float gain;              // applied to the mix
+  unsigned long releaseFrames;  // length of the release ramp
+  unsigned long notes;     // notes started so far, also the next id
+
+  unsigned long chunkFrames;  // of the chunk being rendered
+  float mix[VOICEPOOL_GROUPS][VOICEPOOL_CHUNK];  // per group
+} voicepool;
+
+void voicePoolInit(voicepool *pool, const float *wavetable, int tableBits,
+                   double sampleRate, int maxVoices);
+// returns a handle for the new voice, stealing the oldest when full
+int voicePoolNoteOn(voicepool *pool, float frequency, float amplitude);
+// releases the voice, which is freed once it has faded out; stale handles
+// of stolen voices are ignored
+void voicePoolNoteOff(voicepool *pool, int id);
+// the same addressed by a key chosen by the caller (e.g. a MIDI note), for
+// notes started from a scheduled event whose handle nobody gets to see;
+// noteOff releases every voice still holding that key
+int voicePoolNoteOnKey(voicepool *pool, int key, float frequency,
+                       float amplitude);
+void voicePoolNoteOffKey(voicepool *pool, int key);
+void voicePoolSetFrequency(voicepool *pool, int id, float frequency);
+// sum of all active voices as interleaved stereo, overwrites out
+void voicePoolRender(voicepool *pool, float *out, unsigned long frames);
+
+// eventHandler for a scheduler driving voicePoolCallback: notes by key,
+// parameter events are ignored
+void voicePoolEventHandler(const event *e, void *userData);
+
+// PaStreamCallback rendering the voicepool passed as userData
+int voicePoolCallback(const void *inputBuffer, void *outputBuffer,
+                      unsigned long framesPerBuffer,
+                      const PaStreamCallbackTimeInfo *timeInfo,
+                      PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // VOICEPOOL_H
@@ -0,0 +1,232 @@
+/**
+ *  Purpose:
+ *    memory mapped wavetable bank files, see wavebank.h
+ *
+ *  wavebank.c
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _FILE_OFFSET_BITS 64
+
+#include "wavebank.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "interp.h"
+
+#define WAVEBANK_MAGIC "WTBANK1"
+#define WAVEBANK_ALIGN 4096  // tables start on a page
+
+typedef struct {
+  char magic[8];
+  uint32_t tableBits;
+  uint32_t levels;
+  uint32_t guard;
+  uint32_t tableCount;
+  uint64_t directoryOffset;
+  uint8_t reserved[32];
+} bankheader;  // 64 bytes
+
+typedef struct {
+  char name[WAVEBANK_NAME_LENGTH];
+  uint32_t frames;
+  uint32_t reserved;
+  uint64_t offset;  // first row of frame 0
+  uint8_t padding[16];
+} bankentry;  // 64 bytes
+
+static size_t rowFloats(int tableBits, int guard) {
+  return ((size_t)1 << tableBits) + 2 * (size_t)guard;
+}
+
+static const bankentry *entry(const wavebank *bank, int table) {
+  return (const bankentry *)bank->directory + table;
+}
+
+int waveBankOpen(wavebank *bank, const char *path) {
+  const bankheader *header;
+  const bankentry *e;
+  struct stat st;
+  uint64_t bytes;
+  void *map;
+  int fd, t;
+
+  memset(bank, 0, sizeof(*bank));
+  fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(bankheader)) {
+    close(fd);
+    return -1;
+  }
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // the mapping keeps the file
+  if (map == MAP_FAILED) return -1;
+  // frames are played in any order, reading ahead would only waste memory
+  posix_madvise(map, (size_t)st.st_size, POSIX_MADV_RANDOM);
+
+  bank->map = map;
+  bank->size = (size_t)st.st_size;
+  header = (const bankheader *)map;
+  if (memcmp(header->magic, WAVEBANK_MAGIC, sizeof(WAVEBANK_MAGIC)) != 0 ||
+      header->tableBits < 1 || header->tableBits > MIPMAP_MAX_LEVELS ||
+      header->levels < 1 || header->levels > header->tableBits ||
+      header->guard < WAVETABLE_GUARD || header->guard > 64 ||
+      header->directoryOffset % sizeof(uint64_t) != 0 ||
+      header->directoryOffset > bank->size ||
+      (bank->size - header->directoryOffset) / sizeof(bankentry) <
+          header->tableCount)
+    goto invalid;
+  bank->tableBits = (int)header->tableBits;
+  bank->levels = (int)header->levels;
+  bank->guard = (int)header->guard;
+  bank->tableCount = (int)header->tableCount;
+  bank->directory = bank->map + header->directoryOffset;
+
+  // every table must lie inside the file, so lookups need no checks
+  for (t = 0; t < bank->tableCount; t++) {
+    e = entry(bank, t);
+    bytes = (uint64_t)e->frames * bank->levels *
+            rowFloats(bank->tableBits, bank->guard) * sizeof(float);
+    if (e->name[WAVEBANK_NAME_LENGTH - 1] != '\0' || e->frames < 1 ||
+        e->offset % sizeof(float) != 0 || e->offset > bank->size ||
+        bytes > bank->size - e->offset)
+      goto invalid;
+  }
+  return 0;
+
+invalid:
+  waveBankClose(bank);
+  return -1;
+}
+
+int waveBankOpenTable(wavebank *bank, const char *spec) {
+  char path[4096];
+  const char *colon = strrchr(spec, ':');
+  size_t length = colon != NULL ? (size_t)(colon - spec) : strlen(spec);
+  int table = 0;
+
+  if (length >= sizeof(path)) return -1;
+  memcpy(path, spec, length);
+  path[length] = '\0';
+  if (waveBankOpen(bank, path) != 0) return -1;
+  if (colon != NULL) table = waveBankFind(bank, colon + 1);
+  if (table < 0 || table >= bank->tableCount) {
+    waveBankClose(bank);
+    return -1;
+  }
+  return table;
+}
+
+void waveBankClose(wavebank *bank) {
+  if (bank->map != NULL) munmap((void *)bank->map, bank->size);
+  memset(bank, 0, sizeof(*bank));
+}
+
+static int pad(FILE *file, long alignment) {
+  long position = ftell(file);
+
+  if (position < 0) return -1;
+  for (; position % alignment != 0; position++)
+    if (fputc(0, file) == EOF) return -1;
+  return 0;
+}
+
+int waveBankWrite(const char *path, int tableBits,
+                  const wavebanksource *tables, int count) {
+  const size_t n = (size_t)1 << tableBits;
+  const size_t stride = rowFloats(tableBits, WAVETABLE_GUARD);
+  bankheader header;
+  bankentry e;
+  mipmap m;
+  FILE *file;
+  long offset;
+  int t, f, l, failed = 0;
+
+  file = fopen(path, "wb");
+  if (file == NULL) return -1;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, WAVEBANK_MAGIC, sizeof(WAVEBANK_MAGIC));
+  header.tableBits = (uint32_t)tableBits;
+  header.levels = (uint32_t)tableBits;  // as mipmapInitCycle builds
+  header.guard = WAVETABLE_GUARD;
+  header.tableCount = (uint32_t)count;
+  header.directoryOffset = sizeof(header);
+  if (fwrite(&header, sizeof(header), 1, file) != 1) failed = 1;
+
+  // the directory first, the offsets follow from the sizes alone
+  offset = (long)(sizeof(header) + count * sizeof(bankentry));
+  for (t = 0; t < count && !failed; t++) {
+    offset = (offset + WAVEBANK_ALIGN - 1) / WAVEBANK_ALIGN * WAVEBANK_ALIGN;
+    memset(&e, 0, sizeof(e));
+    strncpy(e.name, tables[t].name, WAVEBANK_NAME_LENGTH - 1);
+    e.frames = (uint32_t)tables[t].frames;
+    e.offset = (uint64_t)offset;
+    if (fwrite(&e, sizeof(e), 1, file) != 1) failed = 1;
+    offset += (long)(tables[t].frames * tableBits * stride * sizeof(float));
+  }
+
+  for (t = 0; t < count && !failed; t++) {
+    if (pad(file, WAVEBANK_ALIGN) != 0) failed = 1;
+    for (f = 0; f < tables[t].frames && !failed; f++) {
+      if (mipmapInitCycle(&m, tables[t].cycles + f * n, tableBits) != 0) {
+        failed = 1;
+        break;
+      }
+      for (l = 0; l < m.levels; l++)
+        if (fwrite(m.level[l] - WAVETABLE_GUARD, sizeof(float), stride,
+                   file) != stride)
+          failed = 1;
+      mipmapFree(&m);
+    }
+  }
+
+  if (fclose(file) != 0) failed = 1;
+  return failed ? -1 : 0;
+}
+
+int waveBankFind(const wavebank *bank, const char *name) {
+  int t;
+
+  for (t = 0; t < bank->tableCount; t++)
+    if (strncmp(entry(bank, t)->name, name, WAVEBANK_NAME_LENGTH) == 0)
+      return t;
+  return -1;
+}
+
+const char *waveBankName(const wavebank *bank, int table) {
+  return entry(bank, table)->name;
+}
+
+int waveBankFrames(const wavebank *bank, int table) {
+  return (int)entry(bank, table)->frames;
+}
+
+const float *waveBankTable(const wavebank *bank, int table, int frame,
+                           int level) {
+  const size_t stride = rowFloats(bank->tableBits, bank->guard);
+  const float *rows = (const float *)(bank->map + entry(bank, table)->offset);
+
+  return rows + ((size_t)frame * bank->levels + level) * stride + bank->guard;
+}
+
+const void *waveBankTableData(const wavebank *bank, int table,
+                              size_t *bytes) {
+  *bytes = (size_t)waveBankFrames(bank, table) * bank->levels *
+           rowFloats(bank->tableBits, bank->guard) * sizeof(float);
+  return bank->map + entry(bank, table)->offset;
+}
+
+void waveBankMipmap(const wavebank *bank, int table, int frame, mipmap *m) {
+  int l;
+
+  memset(m, 0, sizeof(*m));
+  m->tableBits = bank->tableBits;
+  m->levels = bank->levels;
+  for (l = 0; l < m->levels; l++)
+    m->level[l] = waveBankTable(bank, table, frame, l);
+}
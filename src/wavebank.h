@@ -0,0 +1,74 @@
+/**
+ *  Purpose:
+ *    memory mapped wavetable bank files
+ *
+ *  wavebank.h
+ *
+ *  A bank holds many user wavetables, each a series of frames (single
+ *  cycles, e.g. the 256 frames of a Serum style table), every frame
+ *  stored with all its mipmap levels and guard points exactly as the
+ *  lookup loops read them. Opening a bank maps the file read-only and
+ *  checks the header; nothing is parsed or copied, table and mipmap
+ *  pointers point straight into the mapping. The kernel then only reads
+ *  the pages of the frames actually played, so a library of several GB
+ *  costs almost no resident memory.
+ *
+ *  File layout, host byte order (little endian everywhere we run):
+ *
+ *    header     magic "WTBANK1", tableBits, levels, guard, table count,
+ *               offset of the directory
+ *    directory  per table: name, frame count, offset of its first frame
+ *    data       per table, page aligned: frames x levels rows of
+ *               guard + 2^tableBits + guard floats
+ */
+
+#ifndef WAVEBANK_H
+#define WAVEBANK_H
+
+#include <stddef.h>
+#include "mipmap.h"
+
+#define WAVEBANK_NAME_LENGTH 32  // including the terminating 0
+
+typedef struct {
+  const unsigned char *map;  // the whole file
+  size_t size;
+  int tableBits;
+  int levels;                // mipmap levels per frame
+  int guard;                 // guard points on each side of a row
+  int tableCount;
+  const void *directory;
+} wavebank;
+
+// one table to write: frames single cycles of 2^tableBits samples each,
+// one after the other
+typedef struct {
+  const char *name;
+  int frames;
+  const float *cycles;
+} wavebanksource;
+
+// map a bank, 0 on success
+int waveBankOpen(wavebank *bank, const char *path);
+// the same for "path:name" or just "path", returns the index of the table
+// called name (table 0 without a name), or -1 with the bank closed
+int waveBankOpenTable(wavebank *bank, const char *spec);
+void waveBankClose(wavebank *bank);
+// build the mipmaps of every frame with mipmapInitCycle and write a bank
+int waveBankWrite(const char *path, int tableBits,
+                  const wavebanksource *tables, int count);
+
+// index of the table called name, or -1
+int waveBankFind(const wavebank *bank, const char *name);
+const char *waveBankName(const wavebank *bank, int table);
+int waveBankFrames(const wavebank *bank, int table);
+// 2^tableBits points of one frame at a mipmap level, guarded
+const float *waveBankTable(const wavebank *bank, int table, int frame,
+                           int level);
+// every row of a table, all frames and levels, e.g. to prefault it
+const void *waveBankTableData(const wavebank *bank, int table,
+                              size_t *bytes);
+// point m at the levels of one frame, nothing to free
+void waveBankMipmap(const wavebank *bank, int table, int frame, mipmap *m);
+
+#endif  // WAVEBANK_H
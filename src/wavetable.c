@@ -0,0 +1,339 @@
+/**
+ *  Purpose:
+ *    the shared wavetable oscillator, see wavetable.h
+ *
+ *  wavetable.c
+ *
+ *  @see original code http://music.arts.uci.edu/dobrian/CAMP07/wavetable1.c
+ *  @see original code http://music.arts.uci.edu/dobrian/CAMP07/wavetable2.c
+ */
+
+#include "wavetable.h"
+
+#include <math.h>
+#include <stddef.h>
+#include "phasor.h"
+
+#define TWOPI (6.283185307179586)
+#define RAMP_TIME_CONSTANTS 8  // length of an exponential ramp, e^-8 left
+
+void filltable(float *table, unsigned long length) {
+  unsigned long i;
+  const double twopioverlength = TWOPI / length;  // just calculate once
+
+  for (i = 0; i < length; i++) table[i] = sin(i * twopioverlength);
+  wavetableGuard(table, length);  // wrapped points for interpolation
+
+  return;
+}
+
+void waveInit(wave *data, const float *table, int tableBits, float frequency,
+              float amplitude, double sampleRate) {
+  interpInit();
+  data->amplitude = amplitude;
+  data->phase = 0.;
+  data->wavetable = table;
+  data->tableBits = tableBits;
+  data->phasor = phasorFromCycles(data->phase);
+  data->bandlimited = NULL;
+  data->interp = INTERP_LINEAR;
+  data->kernel = oscKernelBest();
+  data->sampleRate = sampleRate;
+  data->params = NULL;
+  data->targetAmplitude = amplitude;
+  data->rampLeft = 0;
+  waveSetRamp(data, RAMP_LINEAR, WAVE_RAMP_SECONDS);
+  waveSetFrequency(data, frequency);
+}
+
+void waveSetFrequency(wave *data, float frequency) {
+  data->frequency = frequency;
+  data->increment = phasorIncrement(frequency, data->sampleRate);
+  data->targetIncrement = data->increment;
+}
+
+void waveSetRamp(wave *data, rampshape shape, double seconds) {
+  data->rampShape = shape;
+  data->rampFrames = (unsigned long)(seconds * data->sampleRate + .5);
+}
+
+static void startRamp(wave *data) {
+  data->rampLeft = data->rampShape == RAMP_EXPONENTIAL
+                       ? data->rampFrames * RAMP_TIME_CONSTANTS
+                       : data->rampFrames;
+  if (data->rampLeft == 0) {
+    data->amplitude = data->targetAmplitude;
+    data->increment = data->targetIncrement;
+  }
+}
+
+void waveRampFrequency(wave *data, float frequency) {
+  data->frequency = frequency;
+  data->targetIncrement = phasorIncrement(frequency, data->sampleRate);
+  startRamp(data);
+}
+
+void waveRampAmplitude(wave *data, float amplitude) {
+  data->targetAmplitude = amplitude;
+  startRamp(data);
+}
+
+static void applyChange(wave *data, parameter param, float value) {
+  switch (param) {
+    case PARAM_FREQUENCY:
+      waveRampFrequency(data, value);
+      break;
+    case PARAM_AMPLITUDE:
+      waveRampAmplitude(data, value);
+      break;
+    case PARAM_PHASE:
+      data->phase = value;
+      data->phasor = phasorFromCycles(data->phase);
+      break;
+    default:
+      break;  // not a parameter of a single table wave
+  }
+}
+
+void waveApplyChanges(wave *data) {
+  paramchange changes[PARAMQUEUE_BATCH];
+  size_t count, i;
+
+  if (data->params == NULL) return;
+  do {
+    count = paramQueueReceive(data->params, changes, PARAMQUEUE_BATCH);
+    for (i = 0; i < count; i++)
+      applyChange(data, changes[i].param, changes[i].value);
+  } while (count == PARAMQUEUE_BATCH);
+}
+
+void waveEventHandler(const event *e, void *userData) {
+  wave *data = (wave *)userData;
+
+  switch (e->type) {
+    case EVENT_NOTE_ON:
+      waveSetFrequency(data, e->value);
+      waveRampAmplitude(data, e->amplitude);
+      break;
+    case EVENT_NOTE_OFF:
+      waveRampAmplitude(data, 0.f);
+      break;
+    case EVENT_PARAM:
+      applyChange(data, (parameter)e->key, e->value);
+      break;
+  }
+}
+
+// one render loop per interpolation kernel and channel count, the kernel
+// is inlined and the channel test folds away
+#define DEFINE_RENDER(name, kernel, channels)                                \
+  static void name(wave *data, const float *table, float *out,               \
+                   unsigned long frames) {                                   \
+    const int bits = data->tableBits;                                        \
+    const uint32_t inc = data->increment;                                    \
+    const float amp = data->amplitude;                                       \
+    uint32_t p = data->phasor;                                               \
+    unsigned long i;                                                         \
+    float y;                                                                 \
+                                                                             \
+    for (i = 0; i < frames; i++) {                                           \
+      y = amp * kernel(table, phasorIndex(p, bits),                          \
+                       phasorFraction(p, bits));                             \
+      p += inc;   /* wraps around by itself */                               \
+      *out++ = y; /* left channel, or the only one */                        \
+      if (channels == 2) *out++ = y; /* right channel */                     \
+    }                                                                        \
+    data->phasor = p;                                                        \
+  }
+
+DEFINE_RENDER(renderTruncate, interpTruncate, 2)
+DEFINE_RENDER(renderHermite, interpHermite, 2)
+DEFINE_RENDER(renderLagrange, interpLagrange, 2)
+DEFINE_RENDER(renderSinc, interpSinc, 2)
+DEFINE_RENDER(renderTruncateMono, interpTruncate, 1)
+DEFINE_RENDER(renderLinearMono, interpLinear, 1)
+DEFINE_RENDER(renderHermiteMono, interpHermite, 1)
+DEFINE_RENDER(renderLagrangeMono, interpLagrange, 1)
+DEFINE_RENDER(renderSincMono, interpSinc, 1)
+
+// the same during a ramp: increment and amplitude change by a fixed step
+// per sample, the phase and gain of sample i are computed in closed form
+// so no sample depends on the previous one
+#define DEFINE_RAMP(name, kernel, channels)                                  \
+  static void name(wave *data, const float *table, float *out,               \
+                   unsigned long frames, uint32_t incStep, float ampStep) {  \
+    const int bits = data->tableBits;                                        \
+    const uint32_t inc = data->increment;                                    \
+    const float amp = data->amplitude;                                       \
+    const uint32_t p = data->phasor;                                         \
+    uint32_t q;                                                              \
+    unsigned long i;                                                         \
+    float y;                                                                 \
+                                                                             \
+    for (i = 0; i < frames; i++) {                                           \
+      /* p + sum of the first i increments, wrapping modulo 2^32 */          \
+      q = p + (uint32_t)i * inc +                                            \
+          (uint32_t)((uint64_t)i * (i - 1) / 2) * incStep;                   \
+      y = (amp + (float)i * ampStep) *                                       \
+          kernel(table, phasorIndex(q, bits), phasorFraction(q, bits));      \
+      *out++ = y;                                                            \
+      if (channels == 2) *out++ = y;                                         \
+    }                                                                        \
+    data->phasor = p + (uint32_t)frames * inc +                              \
+                   (uint32_t)((uint64_t)frames * (frames - 1) / 2) * incStep; \
+  }
+
+DEFINE_RAMP(rampTruncate, interpTruncate, 2)
+DEFINE_RAMP(rampLinear, interpLinear, 2)
+DEFINE_RAMP(rampHermite, interpHermite, 2)
+DEFINE_RAMP(rampLagrange, interpLagrange, 2)
+DEFINE_RAMP(rampSinc, interpSinc, 2)
+DEFINE_RAMP(rampTruncateMono, interpTruncate, 1)
+DEFINE_RAMP(rampLinearMono, interpLinear, 1)
+DEFINE_RAMP(rampHermiteMono, interpHermite, 1)
+DEFINE_RAMP(rampLagrangeMono, interpLagrange, 1)
+DEFINE_RAMP(rampSincMono, interpSinc, 1)
+
+// render the start of a block while a ramp is active, returns the frames
+// rendered: the whole block, or less if the ramp ends inside it
+static unsigned long renderRamp(wave *data, float *out, unsigned long frames,
+                                int channels) {
+  const unsigned long n = frames < data->rampLeft ? frames : data->rampLeft;
+  const float *table = data->wavetable;
+  double x, ampEnd, incEnd;
+  uint32_t incStep;
+  float ampStep;
+
+  if (n == 0) return 0;
+  // how far along towards the targets the ramp is at the end of n frames
+  if (data->rampShape == RAMP_EXPONENTIAL)
+    x = 1. - exp(-(double)n / data->rampFrames);
+  else
+    x = (double)n / data->rampLeft;
+  if (n == data->rampLeft) x = 1.;  // land exactly on the targets
+  ampEnd = data->amplitude + (data->targetAmplitude - data->amplitude) * x;
+  incEnd = data->increment +
+           ((double)data->targetIncrement - data->increment) * x;
+  ampStep = (float)((ampEnd - data->amplitude) / n);
+  incStep = (uint32_t)(int64_t)llround((incEnd - data->increment) / n);
+
+  // the table must be band-limited for the higher of the two pitches
+  if (data->bandlimited != NULL)
+    table = mipmapSelect(data->bandlimited, incEnd > data->increment
+                                                ? (uint32_t)incEnd
+                                                : data->increment);
+
+  switch (data->interp) {
+    case INTERP_TRUNCATE:
+      (channels == 2 ? rampTruncate : rampTruncateMono)(data, table, out, n,
+                                                        incStep, ampStep);
+      break;
+    case INTERP_LINEAR:
+      (channels == 2 ? rampLinear : rampLinearMono)(data, table, out, n,
+                                                    incStep, ampStep);
+      break;
+    case INTERP_HERMITE:
+      (channels == 2 ? rampHermite : rampHermiteMono)(data, table, out, n,
+                                                      incStep, ampStep);
+      break;
+    case INTERP_LAGRANGE:
+      (channels == 2 ? rampLagrange : rampLagrangeMono)(data, table, out, n,
+                                                        incStep, ampStep);
+      break;
+    default:
+      (channels == 2 ? rampSinc : rampSincMono)(data, table, out, n, incStep,
+                                                ampStep);
+      break;
+  }
+
+  data->increment += (uint32_t)n * incStep;
+  data->amplitude = (float)ampEnd;
+  data->rampLeft -= n;
+  if (data->rampLeft == 0) {
+    data->increment = data->targetIncrement;
+    data->amplitude = data->targetAmplitude;
+  }
+  return n;
+}
+
+void waveRender(wave *data, float *out, unsigned long frames) {
+  const float *table = data->wavetable;
+  unsigned long n;
+
+  if (data->rampLeft > 0) {
+    n = renderRamp(data, out, frames, 2);
+    out += 2 * n;
+    frames -= n;
+    if (frames == 0) return;
+  }
+
+  // choose the octave's table once per block, not per sample
+  if (data->bandlimited != NULL)
+    table = mipmapSelect(data->bandlimited, data->increment);
+
+  switch (data->interp) {
+    case INTERP_TRUNCATE:
+      renderTruncate(data, table, out, frames);
+      break;
+    case INTERP_LINEAR:
+      // whole block at once with the SIMD kernel for this CPU
+      data->kernel->render(table, data->tableBits, &data->phasor,
+                           data->increment, data->amplitude, out, frames);
+      break;
+    case INTERP_HERMITE:
+      renderHermite(data, table, out, frames);
+      break;
+    case INTERP_LAGRANGE:
+      renderLagrange(data, table, out, frames);
+      break;
+    default:
+      renderSinc(data, table, out, frames);
+      break;
+  }
+}
+
+void waveRenderMono(wave *data, float *out, unsigned long frames) {
+  const float *table = data->wavetable;
+  unsigned long n;
+
+  if (data->rampLeft > 0) {
+    n = renderRamp(data, out, frames, 1);
+    out += n;
+    frames -= n;
+    if (frames == 0) return;
+  }
+
+  if (data->bandlimited != NULL)
+    table = mipmapSelect(data->bandlimited, data->increment);
+
+  switch (data->interp) {
+    case INTERP_TRUNCATE:
+      renderTruncateMono(data, table, out, frames);
+      break;
+    case INTERP_LINEAR:
+      renderLinearMono(data, table, out, frames);
+      break;
+    case INTERP_HERMITE:
+      renderHermiteMono(data, table, out, frames);
+      break;
+    case INTERP_LAGRANGE:
+      renderLagrangeMono(data, table, out, frames);
+      break;
+    default:
+      renderSincMono(data, table, out, frames);
+      break;
+  }
+}
+
+int sineCallback(const void *inputBuffer, void *outputBuffer,
+                 unsigned long framesPerBuffer,
+                 const PaStreamCallbackTimeInfo *timeInfo,
+                 PaStreamCallbackFlags statusFlags, void *userData) {
+  /* Cast data passed through stream to the format of the local structure. */
+  wave *data = (wave *)userData;
+
+  waveApplyChanges(data);
+  waveRender(data, (float *)outputBuffer, framesPerBuffer);
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ *  Purpose:
+ *    the wavetable oscillator shared by wavetable1.c and wavetable2.c
+ *
+ *  wavetable.h
+ *
+ *  Fill a table with values describing a waveform, then synthesize a tone
+ *  by reading cyclically through that table with a 32-bit phasor. How the
+ *  sample between two table points is found is chosen per wave from the
+ *  kernels in interp.h: wavetable1 truncates, wavetable2 interpolates
+ *  linearly, and the higher orders trade CPU per voice for lower THD.
+ *
+ *  The interpolation is switched once per block, each case running its own
+ *  loop with the kernel inlined, so there is no per sample dispatch.
+ *
+ *  While the stream plays, another thread changes the wave only through
+ *  its paramqueue; sineCallback applies the changes before each block.
+ *  Live changes of frequency and amplitude glide to the new value over a
+ *  few milliseconds instead of stepping, which would click (zipper noise).
+ *  A ramp is rendered by a separate loop; a block without an active ramp
+ *  takes the same path as a static tone and pays nothing for it.
+ */
+
+#ifndef WAVETABLE_H
+#define WAVETABLE_H
+
+#include <stdint.h>
+#include "interp.h"
+#include "mipmap.h"
+#include "osckernel.h"
+#include "paramqueue.h"
+#include "portaudio.h"
+#include "scheduler.h"
+
+#define WAVE_RAMP_SECONDS (0.005)  // default glide of live changes
+
+typedef enum {
+  RAMP_LINEAR,      // straight line, reaches the target after the ramp time
+  RAMP_EXPONENTIAL  // one-pole approach, the ramp time is its time constant
+} rampshape;
+
+typedef struct {
+  float frequency;
+  float amplitude;
+  float phase;                // start phase in cycles
+  const float *wavetable;     // 2^tableBits points, guarded on both sides
+  int tableBits;
+  uint32_t phasor;            // fixed point location, index in the top bits
+  uint32_t increment;         // phasor step per sample
+  const mipmap *bandlimited;  // band-limited tables replacing wavetable
+  interpolation interp;
+  const osckernel *kernel;    // SIMD renderer used for INTERP_LINEAR
+  double sampleRate;
+  paramqueue *params;         // live changes, drained by sineCallback
+  float targetAmplitude;      // amplitude and increment glide towards
+  uint32_t targetIncrement;   // these while rampLeft > 0
+  rampshape rampShape;
+  unsigned long rampFrames;   // ramp time, 0 makes every change a jump
+  unsigned long rampLeft;     // frames until the targets are reached
+} wave;                       // data to pass to callback function
+
+// fill a table with one cycle of a sine waveform and its guard points;
+// table must have WAVETABLE_GUARD writable floats before and after it
+void filltable(float *table, unsigned long length);
+
+// phase 0, linear interpolation, no mipmap, no parameter queue, linear
+// ramps of WAVE_RAMP_SECONDS
+void waveInit(wave *data, const float *table, int tableBits, float frequency,
+              float amplitude, double sampleRate);
+// jump to the frequency at once
+void waveSetFrequency(wave *data, float frequency);
+// shape and time of the ramps started by waveRampFrequency/Amplitude
+void waveSetRamp(wave *data, rampshape shape, double seconds);
+// glide from the current value to a new one, restarting the ramp
+void waveRampFrequency(wave *data, float frequency);
+void waveRampAmplitude(wave *data, float amplitude);
+// audio thread: apply the changes pending in data->params, if it is set
+void waveApplyChanges(wave *data);
+// eventHandler for a scheduler driving sineCallback: note on jumps to the
+// frequency and ramps up the amplitude, note off ramps it down to 0,
+// parameter events are applied like those from the paramqueue
+void waveEventHandler(const event *e, void *userData);
+// render interleaved stereo, the same sample on both channels
+void waveRender(wave *data, float *out, unsigned long frames);
+// render a single channel
+void waveRenderMono(wave *data, float *out, unsigned long frames);
+
+// This routine will be called by the PortAudio engine when audio is needed.
+int sineCallback(const void *inputBuffer, void *outputBuffer,
+                 unsigned long framesPerBuffer,
+                 const PaStreamCallbackTimeInfo *timeInfo,
+                 PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // WAVETABLE_H
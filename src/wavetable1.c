@@ -3,7 +3,21 @@
  *        update wavetable1.c to be compatible with newer portaudio api
  *
  *  compile:
- *       gcc wavetable1.c -lportaudio -o wavetable1
+ *       cmake -S . -B build && cmake --build build   (in the repository root)
+ *
+ *  usage:
+ *       wavetable1 [-b bank.wtb[:table]] [-c capture.wav] [-i interpolation]
+ *                  [-r] [-s] frequency [outfile|- [seconds]]
+ *       -b plays the first frame of a table from a wavetable bank (see
+ *       wavebank.h, built with mkbank) instead of the built-in sine,
+ *       -c records what the stream plays to a float WAV file, written by a
+ *       disk thread so the callback never waits for it (see wavwriter.h),
+ *       -i picks truncate (default), linear, hermite, lagrange or sinc,
+ *       -r locks and prefaults memory, the table included (see rtsetup.h),
+ *       -s reports callback timing, deadline misses and CPU load
+ *       with an outfile the tone is rendered offline as raw float32 stereo
+ *       (or a 32-bit float WAV/RF64 file when it ends in .wav),
+ *       "-" renders without writing anything (callback throughput benchmark)
  *
  *   clang-format:
  *       /Users/julian/bin/clang-format -style=Google -i wavetable1.c
@@ -15,95 +29,148 @@
  *  Then synthesize a tone by reading cyclically through that table
  *  Use simple truncation of calculated sample index
  *  to find the sample value (not as accurate as interpolation)
+ *  The oscillator itself lives in wavetable.c
  *
  *  @see http://music.arts.uci.edu/dobrian/CAMP07/wavetable1.c
  */
 
 #include <stdio.h>
-#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "portaudio.h"
+#include "builtin.h"
+#include "callbackstats.h"
+#include "offline.h"
+#include "rtsetup.h"
+#include "wavebank.h"
+#include "wavetable.h"
+#include "wavwriter.h"
 
 #define SAMPLE_RATE (44100.)
-#define TABLE_LENGTH 1024  // 1024
+#define TABLE_BITS BUILTIN_TABLE_BITS  // log2 of the table length, 10
 #define BUFFER_SIZE 256
-#define TWOPI (6.283185307179586)
 #define NUM_SECONDS (1.)
 #define FREQUENCY (440.)
 #define MAX_AMP (0.5)
+#define CAPTURE_SECONDS (4.)  // -c ring between the callback and the disk
 
-typedef struct {
-  float frequency;
-  float amplitude;
-  float phase;
-  float *wavetable;  // pointer to wavetable
-  float n;           // current location in table
-} wave;              // data to pass to callback function
-
-const float oneoversr = 1. / SAMPLE_RATE;
-
-// fill a table with one cycle of a sine waveform
-void filltable(float *table, unsigned long length);
-// This routine will be called by the PortAudio engine when audio is needed.
-static int sineCallback(const void *inputBuffer, void *outputBuffer,
-                        unsigned long framesPerBuffer,
-                        const PaStreamCallbackTimeInfo *timeInfo,
-                        PaStreamCallbackFlags statusFlags, void *userData);
 int main(int argc, char *argv[]);
 
-void filltable(float *table, unsigned long length) {
-  unsigned long i;
-  const float twopioverlength = TWOPI / length;  // just calculate once
-
-  for (i = 0; i < length; i++) *(table++) = sin(i * twopioverlength);
-
-  return;
-}
-
-static int sineCallback(const void *inputBuffer, void *outputBuffer,
-                        unsigned long framesPerBuffer,
-                        const PaStreamCallbackTimeInfo *timeInfo,
-                        PaStreamCallbackFlags statusFlags, void *userData) {
-  /* Cast data passed through stream to the format of the local structure. */
-  wave *data = (wave *)userData;
-  // float *in = (float*)inputBuffer; // input buffer only needed for input
-  float *out = (float *)outputBuffer;
-
-  unsigned int i;  // a counter
-  float y;         // temp variable for output sample
-
-  for (i = 0; i < framesPerBuffer; i++) {
-    y = data->amplitude * (data->wavetable[(int)data->n]);
-    // increment the wave's counter
-    data->n += data->frequency * TABLE_LENGTH * oneoversr;
-    while (data->n > TABLE_LENGTH) data->n -= TABLE_LENGTH;  // keep it in range
-    *out++ = y;                                              // left channel
-    *out++ = y;                                              // right channel
-  }
-
-  return 0;
-}
-
 int main(int argc, char *argv[]) {
   PaStreamParameters outputParameters;
   PaStream *stream;
   PaError err;
-  wave wave1;                  // my data structure
-  float table1[TABLE_LENGTH];  // wavetable
+  wave wave1;  // my data structure
+  const float *table1 = builtinSine();  // wavetable, built with the program
+  PaStreamCallback *callback = sineCallback;
+  void *userData = &wave1;
+  interpolation interp = INTERP_TRUNCATE;
+  callbackstats stats;
+  timedcallback timed;
+  callbackstatsSnapshot snapshot, last, delta;
+  wavebank bank;
+  const char *bankTable = NULL, *capturePath = NULL;
+  wavwriter capture;
+  wavtap tap;
+  rtstatus rt;
+  const void *data;
+  size_t bytes;
+  int opt, showStats = 0, realtime = 0, k, tableBits = TABLE_BITS, t = -1;
 
   printf("args %d\n", argc);
+  while ((opt = getopt(argc, argv, "b:c:i:rs")) != -1) {
+    if (opt == 'b') {
+      bankTable = optarg;
+    } else if (opt == 'c') {
+      capturePath = optarg;
+    } else if (opt == 'r') {
+      realtime = 1;
+    } else if (opt == 's') {
+      showStats = 1;
+    } else if (opt != 'i' ||
+               (interp = interpolationParse(optarg)) == INTERP_COUNT) {
+      goto usage;
+    }
+  }
+  if (optind >= argc) goto usage;
   float target_freq;
-  sscanf(argv[1], "%f", &target_freq);
-
-  filltable(table1, TABLE_LENGTH);
+  sscanf(argv[optind], "%f", &target_freq);
+
+  // a user wavetable, read straight from the mapped bank file
+  if (bankTable != NULL) {
+    t = waveBankOpenTable(&bank, bankTable);
+    if (t < 0) {
+      fprintf(stderr, "Error: cannot open the wavetable %s.\n", bankTable);
+      return 1;
+    }
+    table1 = waveBankTable(&bank, t, 0, 0);
+    tableBits = bank.tableBits;
+    printf("Wavetable: %s, %d points\n", waveBankName(&bank, t),
+           1 << tableBits);
+  }
 
   printf("PortAudio: wave frequency, %.2f Hz.\n", target_freq);
 
   // Initialize data for use by callback.
-  wave1.frequency = target_freq;
-  wave1.amplitude = MAX_AMP;
-  wave1.phase = 0.;
-  wave1.wavetable = table1;
-  wave1.n = 0. + wave1.phase * TABLE_LENGTH;
+  waveInit(&wave1, table1, tableBits, target_freq, MAX_AMP, SAMPLE_RATE);
+  wave1.interp = interp;
+  printf("Interpolation: %s\n", interpolationName(wave1.interp));
+
+  // with -c the live stream is recorded too, offline renders have their file
+  if (capturePath != NULL && optind + 1 >= argc) {
+    if (wavWriterOpen(&capture, capturePath, 2, SAMPLE_RATE,
+                      CAPTURE_SECONDS) != 0) {
+      fprintf(stderr, "Error: cannot open %s.\n", capturePath);
+      return 1;
+    }
+    tap.callback = callback;
+    tap.userData = userData;
+    tap.writer = &capture;
+    callback = wavTapCallback;
+    userData = &tap;
+  } else {
+    capturePath = NULL;
+  }
+
+  // with -r the stack, the program and the table stay in memory, the built-in
+  // one is part of the program
+  if (realtime) {
+    rtSetup(&rt, NULL, RTSETUP_PRIORITY);
+    if (t >= 0) {
+      data = waveBankTableData(&bank, t, &bytes);
+      rtPrefault(&rt, data, bytes);
+    }
+    if (capturePath != NULL)
+      rtPrefault(&rt, capture.ring.data,
+                 capture.ring.capacity * capture.ring.elementSize);
+    rtSetupPrint(stdout, &rt);
+  }
+
+  // with -s every callback is timed against its deadline
+  if (showStats) {
+    callbackStatsInit(&stats, BUFFER_SIZE, SAMPLE_RATE);
+    timed.callback = callback;
+    timed.userData = userData;
+    timed.stats = &stats;
+    callback = timedCallback;
+    userData = &timed;
+  }
+
+  // with an output file, render offline without touching the sound card
+  if (optind + 1 < argc) {
+    err = renderOffline(
+        callback, userData, argv[optind + 1],
+        optind + 2 < argc ? atof(argv[optind + 2]) : NUM_SECONDS, SAMPLE_RATE,
+        BUFFER_SIZE);
+    if (err != paNoError) goto error;
+    if (showStats) {
+      callbackStatsSnapshot(&stats, &snapshot);
+      callbackStatsPrint(stdout, &snapshot);
+    }
+    printf("Finished.\n");
+    return err;
+  }
 
   // Initialize library before making any other calls.
   err = Pa_Initialize();
@@ -126,14 +193,27 @@ int main(int argc, char *argv[]) {
       &stream, NULL,                               /* no input */
       &outputParameters, SAMPLE_RATE, BUFFER_SIZE, /* frames per buffer */
       paClipOff, /* number of buffers, if zero then use default minimum */
-      sineCallback, &wave1);
+      callback, userData);
 
   if (err != paNoError) goto error;
 
   err = Pa_StartStream(stream);
   if (err != paNoError) goto error;
 
-  Pa_Sleep(NUM_SECONDS * 1000.);
+  // Play for NUM_SECONDS, with -s report the callback timing every second.
+  if (showStats) {
+    memset(&last, 0, sizeof(last));
+    for (k = 0; k < NUM_SECONDS; k++) {
+      Pa_Sleep(1000);
+      callbackStatsSnapshot(&stats, &snapshot);
+      callbackStatsDelta(&snapshot, &last, &delta);
+      delta.cpuLoad = Pa_GetStreamCpuLoad(stream);
+      callbackStatsPrint(stdout, &delta);
+      last = snapshot;
+    }
+  } else {
+    Pa_Sleep(NUM_SECONDS * 1000.);
+  }
 
   err = Pa_StopStream(stream);
   if (err != paNoError) goto error;
@@ -142,10 +222,24 @@ int main(int argc, char *argv[]) {
   if (err != paNoError) goto error;
 
   Pa_Terminate();
+  if (capturePath != NULL) {
+    printf("Captured %s, %llu frames dropped.\n", capturePath,
+           (unsigned long long)atomic_load(&capture.droppedFrames));
+    if (wavWriterClose(&capture) != 0)
+      fprintf(stderr, "Error: cannot write %s.\n", capturePath);
+  }
   printf("Finished.\n");
 
   return err;
 
+usage:
+  fprintf(stderr,
+          "usage: %s [-b bank.wtb[:table]] [-c capture.wav] "
+          "[-i truncate|linear|hermite|lagrange|sinc] [-r] [-s] "
+          "frequency [outfile|- [seconds]]\n",
+          argv[0]);
+  return 1;
+
 error:
   Pa_Terminate();
   fprintf(stderr, "An error occured while using the portaudio stream.\n");
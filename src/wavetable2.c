@@ -2,8 +2,40 @@
  *  Purpose:
  *    modernize wavetable2.c to be compatible with newer portaudio api
  *
- *  gcc compile:
- *    gcc wavetable2.c -lportaudio -o wavetable2
+ *  compile:
+ *    cmake -S . -B build && cmake --build build   (in the repository root)
+ *
+ *  usage:
+ *    wavetable2 [-a] [-b bank.wtb[:table]] [-c capture.wav] [-f algorithm]
+ *               [-g cutoff] [-i interpolation] [-m] [-p partials] [-r] [-s]
+ *               [-t threads] [-u copies] [-v voices]
+ *               [-w sine|saw|square|triangle] [-x partials]
+ *               [outfile|- [seconds]]
+ *    -a plays an arpeggio of scheduled notes, each starting on its exact
+ *    sample frame (over the chord with -v), -b plays the mipmaps of a table
+ *    from a wavetable bank, sweeping the position back and forth across its
+ *    frames when it has several (only the first with -v or -f), -c records
+ *    what the stream plays to a float WAV file, written by a disk thread so
+ *    the callback never waits for it (see wavwriter.h), -f plays the tone
+ *    or the -v chord with six operator FM voices of that algorithm (stack,
+ *    twostacks, pairstack, threepairs, branch, fan or organ), -g runs the
+ *    sound through a processing graph, a lowpass at cutoff Hz mixed with a
+ *    sine an octave below (see graph.h), -i picks truncate, linear
+ *    (default), hermite, lagrange or sinc, -m adds a vibrato to the live
+ *    tone, sent to the callback every ms, -p plays the tone on the
+ *    additive bank as a plucked string of that many partials
+ *    (those above Nyquist are culled), -r locks and prefaults memory and
+ *    runs the -t workers at SCHED_FIFO on isolated cores (see rtsetup.h),
+ *    -s reports callback timing, deadline misses and CPU load, -t renders
+ *    the -v voices on that many worker threads besides the callback's, -u
+ *    plays the tone as a stack of that many detuned, panned copies (2 to
+ *    16, a supersaw with -w saw), -v plays a chord from the voice pool, -w
+ *    uses band-limited mipmap tables of that waveform and -x plays the
+ *    tone as that many partials of a stiff string on the inverse FFT bank
+ *    (tens of thousands are fine)
+ *    with an outfile the tone is rendered offline as raw float32 stereo
+ *    (or a 32-bit float WAV/RF64 file when it ends in .wav),
+ *    "-" renders without writing anything (callback throughput benchmark)
  *
  *  clang-format:
  *    /Users/julian/bin/clang-format -style=Google -i wavetable1.c
@@ -14,98 +46,431 @@
  *  Fill a table with values describing a waveform. Then synthesize a tone by
  *  reading cyclically through that table. Calculate the actual sample value by
  *  means of linear interpolation between two adjacent sample indices (more
- *  accurate than simple truncation of sample index).
+ *  accurate than simple truncation of sample index). The oscillator itself
+ *  lives in wavetable.c.
  *
  *  @see original code http://music.arts.uci.edu/dobrian/CAMP07/wavetable2.c
  *
  */
 
-#include <stdio.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "portaudio.h"
+#include "additive.h"
+#include "builtin.h"
+#include "callbackstats.h"
+#include "fm.h"
+#include "graph.h"
+#include "mipmap.h"
+#include "morph.h"
+#include "offline.h"
+#include "paramqueue.h"
+#include "rtsetup.h"
+#include "spectral.h"
+#include "unison.h"
+#include "voicepool.h"
+#include "wavebank.h"
+#include "wavetable.h"
+#include "workerpool.h"
+#include "wavwriter.h"
 
 #define SAMPLE_RATE (44100.)
-#define TABLE_LENGTH 1024
+#define TABLE_BITS BUILTIN_TABLE_BITS  // log2 of the table length, 10
 #define BUFFER_SIZE 256
-#define TWOPI (6.283185307179586)
 #define NUM_SECONDS (4.)
 #define FREQUENCY (440.)
 #define MAX_AMP (0.5)
+#define VIBRATO_RATE (5.)     // Hz
+#define VIBRATO_DEPTH (0.01)  // of the frequency, about a sixth of a tone
+#define TWOPI (6.283185307179586)
+#define ARPEGGIO_RATE (8.)  // notes per second
+#define SWEEP_SECONDS (2.)  // -b position sweep, first frame to the last
+#define SWEEP_RATE (50.)    // position changes per second, glided in between
+#define CAPTURE_SECONDS (4.)  // -c ring between the callback and the disk
+
+static voicepool pool;      // voices for the -v chord
+static workerpool workers;  // threads sharing them for -t
+static fmsynth fm;          // or FM voices for -f
+static mipmap bandlimited;  // tables for the -w waveform or the -b bank
+static wavebank bank;       // mapped wavetable bank for -b
+static morphwave morph;     // position sweep of a multi-frame -b table
+static unisonwave unison;   // detuned stack for -u
+static additive bank2;      // partials for -p
+static additivepartial partials[ADDITIVE_MAX_PARTIALS];
+static spectralbank spectral;  // partials for -x
+static paramqueue params;   // frequency changes for the -m vibrato
+static scheduler sched;     // notes for the -a arpeggio
+static graph processing;    // filter and mixer for -g
+static wave sub;            // sine an octave below, mixed in by -g
+static wavwriter capture;   // recording of the live stream for -c
+static wavtap tap;          // the callback that feeds it
 
-typedef struct {
-  float frequency;
-  float amplitude;
-  float phase;
-  float *wavetable;
-  float n;
-} wave;  // data to pass to callback function
-
-const float oneoversr = 1. / SAMPLE_RATE;
-
-// fill a table with one cycle of a sine waveform
-void filltable(float *table, unsigned long length);
-// This routine will be called by the PortAudio engine when audio is needed.
-static int sineCallback(const void *inputBuffer, void *outputBuffer,
-                        unsigned long framesPerBuffer,
-                        const PaStreamCallbackTimeInfo *timeInfo,
-                        PaStreamCallbackFlags statusFlags, void *userData);
-int main(void);
-
-void filltable(float *table, unsigned long length) {
-  unsigned long i;
-  const float twopioverlength = 8. * atan(1.) / length;  // or TWOPI/length
-
-  for (i = 0; i < length; i++) *(table++) = sin(i * twopioverlength);
-  *table = 0.;  // final (returning) point for interpolation purposes
-
-  return;
-}
-
-static int sineCallback(const void *inputBuffer, void *outputBuffer,
-                        unsigned long framesPerBuffer,
-                        const PaStreamCallbackTimeInfo *timeInfo,
-                        PaStreamCallbackFlags statusFlags, void *userData) {
-  /* Cast data passed through stream to the format of the local structure. */
-  wave *data = (wave *)userData;
-  // float *in = (float*)inputBuffer; // input buffer only needed for input
-  float *out = (float *)outputBuffer;
-
-  unsigned int i;  // a counter
-  float f;         // hold fractional part of sample index
-  float y;         // temp variable for output sample
-
-  for (i = 0; i < framesPerBuffer; i++) {
-    f = data->n - (int)data->n;  // get fractional part of index
-    // use it to interpolate between the two closest sample indices
-    y = data->amplitude * ((1. - f) * (data->wavetable[(int)data->n]) +
-                           f * (data->wavetable[(int)data->n + 1]));
-    data->n += data->frequency * TABLE_LENGTH *
-               oneoversr;  // increment the wave's counter
-    while (data->n > TABLE_LENGTH) data->n -= TABLE_LENGTH;  // keep it in range
-    *out++ = y;                                              /* left channel */
-    *out++ = y;                                              /* right channel*/
-  }
-
-  return 0;
-}
-
-int main(void) {
+int main(int argc, char *argv[]);
+
+int main(int argc, char *argv[]) {
   PaStreamParameters outputParameters;
   PaStream *stream;
   PaError err;
-  wave wave2;                      // my data structure
-  float table2[TABLE_LENGTH + 1];  // wavetable with final interpolation point
+  wave wave2;  // my data structure
+  const float *table2 = builtinSine();  // wavetable with guard points
+  PaStreamCallback *callback = sineCallback;
+  void *userData = &wave2;
+  eventHandler handler = waveEventHandler;  // for the scheduler
+  interpolation interp = INTERP_LINEAR;
+  fmalgorithm algorithm = FM_ALGO_COUNT;  // no FM
+  fmpatch patch;
+  const char *shape = NULL, *bankTable = NULL, *capturePath = NULL;
+  callbackstats stats;
+  timedcallback timed;
+  callbackstatsSnapshot snapshot, last, delta;
+  rtstatus rt;
+  const void *data;
+  size_t bytes;
+  static const float arpeggio[4] = {1.f, 1.25f, 1.5f, 2.f};  // major chord
+  int opt, voices = 0, showStats = 0, vibrato = 0, arpeggiate = 0,
+           morphing = 0, copies = 0, partialCount = 0, spectralCount = 0,
+           threads = 0, realtime = 0, k, period, ms, t = -1;
+  int source, filter, mixer;
+  double lfo, seconds, sweep, cutoff = 0.;
+  event e;
 
-  filltable(table2, TABLE_LENGTH);
+  while ((opt = getopt(argc, argv, "ab:c:f:g:i:mp:rst:u:v:w:x:")) != -1) {
+    if (opt == 'a') {
+      arpeggiate = 1;
+    } else if (opt == 'b') {
+      bankTable = optarg;
+    } else if (opt == 'c') {
+      capturePath = optarg;
+    } else if (opt == 'f' &&
+               (algorithm = fmAlgorithmParse(optarg)) != FM_ALGO_COUNT) {
+      continue;
+    } else if (opt == 'g') {
+      cutoff = atof(optarg);
+    } else if (opt == 'i' &&
+               (interp = interpolationParse(optarg)) != INTERP_COUNT) {
+      continue;
+    } else if (opt == 'm') {
+      vibrato = 1;
+    } else if (opt == 'p') {
+      partialCount = atoi(optarg);
+    } else if (opt == 'r') {
+      realtime = 1;
+    } else if (opt == 's') {
+      showStats = 1;
+    } else if (opt == 't') {
+      threads = atoi(optarg);
+    } else if (opt == 'u') {
+      copies = atoi(optarg);
+    } else if (opt == 'v') {
+      voices = atoi(optarg);
+    } else if (opt == 'w') {
+      shape = optarg;
+    } else if (opt == 'x') {
+      spectralCount = atoi(optarg);
+    } else {
+      fprintf(stderr,
+              "usage: %s [-a] [-b bank.wtb[:table]] [-c capture.wav] "
+              "[-f stack|twostacks|pairstack|threepairs|branch|fan|organ] "
+              "[-g cutoff] [-i truncate|linear|hermite|lagrange|sinc] "
+              "[-m] [-p partials] [-r] [-s] [-t threads] [-u copies] "
+              "[-v voices] [-w sine|saw|square|triangle] [-x partials] "
+              "[outfile|- [seconds]]\n",
+              argv[0]);
+      return 1;
+    }
+  }
 
   printf("PortAudio: Sine Wave, %.2f Hz.\n", FREQUENCY);
 
   // Initialize data for use by callback.
-  wave2.frequency = FREQUENCY;
-  wave2.amplitude = MAX_AMP;
-  wave2.phase = 0.;
-  wave2.wavetable = table2;
-  wave2.n = 0. + wave2.phase * TABLE_LENGTH;
+  waveInit(&wave2, table2, TABLE_BITS, FREQUENCY, MAX_AMP, SAMPLE_RATE);
+  wave2.interp = interp;
+  printf("Interpolation: %s", interpolationName(wave2.interp));
+  if (wave2.interp == INTERP_LINEAR) printf(", kernel %s", wave2.kernel->name);
+  printf("\n");
+
+  // band-limited mipmaps instead of the single sine table
+  if (shape != NULL) {
+    waveform w = strcmp(shape, "saw") == 0        ? WAVEFORM_SAW
+                 : strcmp(shape, "square") == 0   ? WAVEFORM_SQUARE
+                 : strcmp(shape, "triangle") == 0 ? WAVEFORM_TRIANGLE
+                                                  : WAVEFORM_SINE;
+    builtinMipmap(&bandlimited, w);
+    printf("Waveform: %s, %d octave tables\n", shape, bandlimited.levels);
+    wave2.bandlimited = &bandlimited;
+  }
+
+  // or the mipmaps of a user wavetable, straight from the mapped bank
+  if (bankTable != NULL) {
+    t = waveBankOpenTable(&bank, bankTable);
+    if (t < 0) {
+      fprintf(stderr, "Error: cannot open the wavetable %s.\n", bankTable);
+      return 1;
+    }
+    waveBankMipmap(&bank, t, 0, &bandlimited);
+    printf("Wavetable: %s, %d frames of %d points\n", waveBankName(&bank, t),
+           waveBankFrames(&bank, t), 1 << bank.tableBits);
+    wave2.wavetable = bandlimited.level[0];
+    wave2.tableBits = bank.tableBits;
+    wave2.bandlimited = &bandlimited;
+
+    // several frames: scan them with the morphing oscillator
+    if (waveBankFrames(&bank, t) > 1 && voices == 0 &&
+        algorithm == FM_ALGO_COUNT) {
+      morphInitBank(&morph, &bank, t, FREQUENCY, MAX_AMP, SAMPLE_RATE);
+      printf("Morph: position swept over %.0f s, kernel %s\n", SWEEP_SECONDS,
+             morph.kernel->name);
+      callback = morphCallback;
+      userData = &morph;
+      handler = morphEventHandler;
+      morphing = 1;
+    }
+  }
+
+  // the vibrato is sent by this thread while the stream plays
+  if (vibrato) {
+    if (paramQueueInit(&params, 1024) != 0) {
+      fprintf(stderr, "Error: cannot allocate the parameter queue.\n");
+      return 1;
+    }
+    wave2.params = &params;
+  }
+
+  // or a unison stack of the single tone
+  if (copies > 0 && !morphing) {
+    unisonInit(&unison, wave2.wavetable, wave2.tableBits, copies, FREQUENCY,
+               MAX_AMP, SAMPLE_RATE);
+    unison.bandlimited = wave2.bandlimited;
+    printf("Unison: %d copies, %.0f cents, kernel %s\n", unison.copies,
+           unison.detune, unison.kernel->name);
+    callback = unisonCallback;
+    userData = &unison;
+    handler = unisonEventHandler;
+  }
+
+  // or a plucked string of many partials, the high ones dying first
+  if (partialCount > 0) {
+    if (partialCount > ADDITIVE_MAX_PARTIALS)
+      partialCount = ADDITIVE_MAX_PARTIALS;
+    for (k = 0; k < partialCount; k++) {
+      partials[k].ratio = (k + 1) * (1.f + .0002f * k);
+      partials[k].amplitude = .5f / (k + 1);
+      partials[k].decay = 2.f / (1.f + .1f * k);
+    }
+    additiveInit(&bank2, SAMPLE_RATE);
+    additiveSetPartials(&bank2, partials, partialCount);
+    additiveNoteOn(&bank2, FREQUENCY, MAX_AMP);
+    printf("Additive: %d partials, %d below Nyquist, %s\n", partialCount,
+           bank2.belowNyquist, bank2.kernelName);
+    callback = additiveCallback;
+    userData = &bank2;
+    handler = additiveEventHandler;
+  }
+
+  // or as many partials as the inverse FFT bank will take
+  if (spectralCount > 0) {
+    if (spectralInit(&spectral, SPECTRAL_FRAME_BITS, spectralCount,
+                     SAMPLE_RATE) != 0) {
+      fprintf(stderr, "Error: cannot allocate %d partials.\n",
+              spectralCount);
+      return 1;
+    }
+    spectralSetFrequency(&spectral, FREQUENCY);
+    for (k = 0; k < spectralCount; k++)
+      spectralSetPartial(&spectral, k, (k + 1) * (1.f + .0002f * k),
+                         .3f / (k + 1));
+    spectral.amplitude = MAX_AMP;
+    printf("Spectral: %d partials, %d point frames\n", spectralCount,
+           spectral.frameLength);
+    callback = spectralCallback;
+    userData = &spectral;
+    handler = spectralEventHandler;
+  }
+
+  // a chord of slightly detuned harmonics played by the voice pool
+  if (voices > 0) {
+    voicePoolInit(&pool, wave2.wavetable, wave2.tableBits, SAMPLE_RATE,
+                  voices);
+    pool.bandlimited = wave2.bandlimited;
+    for (k = 0; k < voices; k++)
+      voicePoolNoteOn(&pool, FREQUENCY * (1 + k % 8) * (1. + .0007 * k),
+                      MAX_AMP / voices);
+    printf("Voices: %d\n", pool.activeCount);
+    if (threads > 0) {
+      if (workerPoolInit(&workers, threads, NULL) != 0) {
+        fprintf(stderr, "Error: cannot start %d worker threads.\n",
+                threads);
+        return 1;
+      }
+      pool.workers = &workers;
+      printf("Workers: %d threads, groups of %d voices\n",
+             workers.threadCount, VOICEPOOL_GROUP);
+    }
+    callback = voicePoolCallback;
+    userData = &pool;
+    handler = voicePoolEventHandler;
+  }
+
+  // the same notes on FM voices, a bright patch with some feedback
+  if (algorithm != FM_ALGO_COUNT) {
+    fmInit(&fm, table2, TABLE_BITS, SAMPLE_RATE, voices > 0 ? voices : 1);
+    fmPatchInit(&patch, algorithm);
+    patch.ratio[1] = 2.f;
+    patch.ratio[3] = 3.f;
+    patch.feedback = .5f;
+    fmSetPatch(&fm, &patch);
+    for (k = 0; k < (voices > 0 ? voices : 1); k++)
+      fmNoteOn(&fm, -1, FREQUENCY * (1 + k % 8) * (1. + .0007 * k),
+               voices > 0 ? MAX_AMP / voices : MAX_AMP);
+    printf("FM: %s, %d voices\n", fmAlgorithmName(algorithm),
+           fm.activeCount);
+    callback = fmCallback;
+    userData = &fm;
+    handler = fmEventHandler;
+  }
+
+  // the arpeggio and the position sweep are scheduled up front, so offline
+  // renders are repeatable
+  seconds = optind + 1 < argc ? atof(argv[optind + 1]) : NUM_SECONDS;
+  if (arpeggiate || morphing) {
+    if (schedulerInit(&sched, callback, userData, handler, 2, SAMPLE_RATE) !=
+        0) {
+      fprintf(stderr, "Error: cannot allocate the event scheduler.\n");
+      return 1;
+    }
+    callback = schedulerCallback;
+    userData = &sched;
+  }
+  memset(&e, 0, sizeof(e));
+  if (morphing) {
+    e.type = EVENT_PARAM;
+    e.key = PARAM_POSITION;
+    for (k = 1; k <= seconds * SWEEP_RATE; k++) {
+      e.frame = (unsigned long long)(k * SAMPLE_RATE / SWEEP_RATE);
+      sweep = fmod(k / (SWEEP_RATE * SWEEP_SECONDS), 2.);  // triangle, 0 to 1
+      e.value = (float)((sweep < 1. ? sweep : 2. - sweep) *
+                        (morph.frameCount - 1));
+      if (schedulerSend(&sched, &e) != 0) break;
+    }
+    // the scheduler holds SCHEDULER_MAX_EVENTS, longer sweeps are cut short
+    printf("Morph: %d position changes", k - 1);
+    if (k <= seconds * SWEEP_RATE)
+      printf(", the scheduler is full, the sweep stops after %.1f s",
+             (k - 1) / SWEEP_RATE);
+    printf("\n");
+  }
+  if (arpeggiate) {
+    wave2.amplitude = wave2.targetAmplitude = 0.f;  // silent between notes
+    if (morphing) morphSetAmplitude(&morph, 0.f);
+    if (copies > 0) unisonSetAmplitude(&unison, 0.f);
+    for (k = 0; k < seconds * ARPEGGIO_RATE; k++) {
+      e.frame = (unsigned long long)(k * SAMPLE_RATE / ARPEGGIO_RATE);
+      e.type = EVENT_NOTE_ON;
+      e.key = k % 4;
+      e.value = FREQUENCY * arpeggio[k % 4];
+      e.amplitude = voices > 0 ? MAX_AMP / 2 : MAX_AMP;
+      if (schedulerSend(&sched, &e) != 0) break;
+      e.frame += (unsigned long long)(.75 * SAMPLE_RATE / ARPEGGIO_RATE);
+      e.type = EVENT_NOTE_OFF;
+      if (schedulerSend(&sched, &e) != 0) break;
+    }
+    printf("Arpeggio: %d notes", k);
+    if (k < seconds * ARPEGGIO_RATE)
+      printf(", the scheduler is full, the arpeggio stops after %.1f s",
+             k / ARPEGGIO_RATE);
+    printf("\n");
+  }
+
+  // the sound as one source of a graph, compiled before the stream starts
+  if (cutoff > 0.) {
+    graphInit(&processing, SAMPLE_RATE);
+    waveInit(&sub, table2, TABLE_BITS, FREQUENCY / 2., MAX_AMP, SAMPLE_RATE);
+    source = graphAddSource(&processing, callback, userData);
+    filter = graphAddFilter(&processing, FILTER_LOWPASS, cutoff, M_SQRT1_2);
+    mixer = graphAddMixer(&processing);
+    graphConnect(&processing, source, filter, 1.f);
+    graphConnect(&processing, filter, mixer, .7f);
+    graphConnect(&processing, graphAddSource(&processing, sineCallback, &sub),
+                 mixer, .3f);
+    graphSetOutput(&processing, mixer);
+    if (graphCompile(&processing) != 0) {
+      fprintf(stderr, "Error: cannot compile the processing graph.\n");
+      return 1;
+    }
+    printf("Graph: lowpass at %.0f Hz and a sub octave, %d steps in %d "
+           "buffers\n",
+           cutoff, processing.stepCount, processing.bufferCount);
+    callback = graphCallback;
+    userData = &processing;
+  }
+
+  // with -c the live stream is recorded too, offline renders have their file
+  if (capturePath != NULL && optind >= argc) {
+    if (wavWriterOpen(&capture, capturePath, 2, SAMPLE_RATE,
+                      CAPTURE_SECONDS) != 0) {
+      fprintf(stderr, "Error: cannot open %s.\n", capturePath);
+      return 1;
+    }
+    tap.callback = callback;
+    tap.userData = userData;
+    tap.writer = &capture;
+    callback = wavTapCallback;
+    userData = &tap;
+  } else {
+    capturePath = NULL;
+  }
+
+  // with -r nothing the callback touches may fault any more: the program
+  // image and stack are covered by rtSetup, the rest is added here
+  if (realtime) {
+    rtSetup(&rt, pool.workers, RTSETUP_PRIORITY);
+    if (t >= 0) {
+      data = waveBankTableData(&bank, t, &bytes);
+      rtPrefault(&rt, data, bytes);
+    }
+    if (spectralCount > 0) {
+      bytes = spectral.frameLength * sizeof(double);
+      rtPrefault(&rt, spectral.re, bytes);
+      rtPrefault(&rt, spectral.im, bytes);
+      rtPrefault(&rt, spectral.sum, spectral.frameLength * sizeof(float));
+    }
+    if (arpeggiate || morphing)
+      rtPrefault(&rt, sched.inbox.data,
+                 sched.inbox.capacity * sched.inbox.elementSize);
+    if (vibrato)
+      rtPrefault(&rt, params.ring.data,
+                 params.ring.capacity * params.ring.elementSize);
+    if (capturePath != NULL)
+      rtPrefault(&rt, capture.ring.data,
+                 capture.ring.capacity * capture.ring.elementSize);
+    rtSetupPrint(stdout, &rt);
+  }
+
+  // with -s every callback is timed against its deadline
+  if (showStats) {
+    callbackStatsInit(&stats, BUFFER_SIZE, SAMPLE_RATE);
+    timed.callback = callback;
+    timed.userData = userData;
+    timed.stats = &stats;
+    callback = timedCallback;
+    userData = &timed;
+  }
+
+  // with an output file, render offline without touching the sound card
+  if (optind < argc) {
+    err = renderOffline(callback, userData, argv[optind], seconds,
+                        SAMPLE_RATE, BUFFER_SIZE);
+    if (err != paNoError) goto error;
+    if (showStats) {
+      callbackStatsSnapshot(&stats, &snapshot);
+      callbackStatsPrint(stdout, &snapshot);
+    }
+    printf("Finished.\n");
+    return err;
+  }
 
   // Initialize library before making any other calls.
   err = Pa_Initialize();
@@ -128,15 +493,35 @@ int main(void) {
       &stream, NULL,                               /* no input */
       &outputParameters, SAMPLE_RATE, BUFFER_SIZE, /* frames per buffer */
       paClipOff, /* number of buffers, if zero then use default minimum */
-      sineCallback, &wave2);
+      callback, userData);
 
   if (err != paNoError) goto error;
 
   err = Pa_StartStream(stream);
   if (err != paNoError) goto error;
 
-  // Sleep for several seconds.
-  Pa_Sleep(NUM_SECONDS * 1000.);
+  // Play for NUM_SECONDS. With -m send the vibrato every millisecond, with
+  // -s report the callback timing every second.
+  memset(&last, 0, sizeof(last));
+  period = vibrato ? 1 : 1000;
+  for (ms = period; ms <= NUM_SECONDS * 1000; ms += period) {
+    Pa_Sleep(period);
+    if (vibrato) {
+      lfo = sin(TWOPI * VIBRATO_RATE * ms * 1e-3);
+      paramQueueSend(&params, PARAM_FREQUENCY,
+                     FREQUENCY * (1. + VIBRATO_DEPTH * lfo));
+    }
+    if (showStats && ms % 1000 == 0) {
+      callbackStatsSnapshot(&stats, &snapshot);
+      callbackStatsDelta(&snapshot, &last, &delta);
+      delta.cpuLoad = Pa_GetStreamCpuLoad(stream);
+      callbackStatsPrint(stdout, &delta);
+      last = snapshot;
+    }
+  }
+  if (vibrato && atomic_load(&params.dropped) > 0)
+    printf("Vibrato: %llu changes dropped, the queue was full.\n",
+           (unsigned long long)atomic_load(&params.dropped));
 
   err = Pa_StopStream(stream);
   if (err != paNoError) goto error;
@@ -145,6 +530,12 @@ int main(void) {
   if (err != paNoError) goto error;
 
   Pa_Terminate();
+  if (capturePath != NULL) {
+    printf("Captured %s, %llu frames dropped.\n", capturePath,
+           (unsigned long long)atomic_load(&capture.droppedFrames));
+    if (wavWriterClose(&capture) != 0)
+      fprintf(stderr, "Error: cannot write %s.\n", capturePath);
+  }
   printf("Finished.\n");
 
   return err;
@@ -0,0 +1,219 @@
+/**
+ *  Purpose:
+ *    streaming 32-bit float WAV / RF64 writer, see wavwriter.h
+ *
+ *  wavwriter.c
+ *
+ *  Samples are stored in host byte order, which is little endian on every
+ *  platform we render on; the header fields are packed explicitly.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _FILE_OFFSET_BITS 64
+
+#include "wavwriter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HEADER_BYTES 94           // RIFF + JUNK/ds64 + fmt + fact + data
+#define RIFF_LIMIT 0xFFFFFFFFull  // largest size a 32-bit chunk can hold
+
+static void put16(unsigned char *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put32(unsigned char *p, uint32_t v) {
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+static void put64(unsigned char *p, uint64_t v) {
+  put32(p, v & 0xFFFFFFFF);
+  put32(p + 4, v >> 32);
+}
+
+// build the header for dataBytes of samples; before close dataBytes is 0
+static void buildHeader(unsigned char *h, const wavwriter *w,
+                        unsigned long long dataBytes) {
+  uint64_t riffSize = HEADER_BYTES - 8 + dataBytes;
+  uint64_t frames = dataBytes / (w->channelCount * sizeof(float));
+  int rf64 = riffSize > RIFF_LIMIT;
+
+  memset(h, 0, HEADER_BYTES);
+  memcpy(h, rf64 ? "RF64" : "RIFF", 4);
+  put32(h + 4, rf64 ? RIFF_LIMIT : riffSize);
+  memcpy(h + 8, "WAVE", 4);
+  // a JUNK chunk the size of ds64, so the header can be upgraded in place
+  memcpy(h + 12, rf64 ? "ds64" : "JUNK", 4);
+  put32(h + 16, 28);
+  if (rf64) {
+    put64(h + 20, riffSize);
+    put64(h + 28, dataBytes);
+    put64(h + 36, frames);
+  }
+  memcpy(h + 48, "fmt ", 4);
+  put32(h + 52, 18);
+  put16(h + 56, 3);  // WAVE_FORMAT_IEEE_FLOAT
+  put16(h + 58, w->channelCount);
+  put32(h + 60, (uint32_t)w->sampleRate);
+  put32(h + 64, (uint32_t)w->sampleRate * w->channelCount * sizeof(float));
+  put16(h + 68, w->channelCount * sizeof(float));
+  put16(h + 70, 32);
+  memcpy(h + 74, "fact", 4);
+  put32(h + 78, 4);
+  put32(h + 82, rf64 ? RIFF_LIMIT : frames);
+  memcpy(h + 86, "data", 4);
+  put32(h + 90, rf64 ? RIFF_LIMIT : dataBytes);
+}
+
+static int writeAll(int fd, const char *p, size_t bytes) {
+  ssize_t n;
+
+  while (bytes > 0) {
+    n = write(fd, p, bytes);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    bytes -= n;
+  }
+
+  return 0;
+}
+
+static void sleepNanoseconds(long nanoseconds) {
+  struct timespec ts = {0, nanoseconds};
+  nanosleep(&ts, NULL);
+}
+
+// disk thread: gather whole blocks from the ring and write them out
+static void *writerThread(void *arg) {
+  wavwriter *w = (wavwriter *)arg;
+  size_t frameBytes = w->channelCount * sizeof(float);
+  size_t blockFrames = WAVWRITER_BLOCK_BYTES / frameBytes;
+  size_t fill = 0, n, size1, size2;
+  void *data1, *data2;
+  int running;
+
+  for (;;) {
+    running = atomic_load(&w->running);
+    n = ringBufferGetReadRegions(&w->ring, blockFrames - fill, &data1, &size1,
+                                 &data2, &size2);
+    memcpy(w->block + fill * frameBytes, data1, size1 * frameBytes);
+    memcpy(w->block + (fill + size1) * frameBytes, data2, size2 * frameBytes);
+    ringBufferAdvanceRead(&w->ring, n);
+    fill += n;
+
+    // flush full blocks, and the tail once the producer has stopped
+    if (fill == blockFrames || (!running && n == 0 && fill > 0)) {
+      if (writeAll(w->fd, w->block, fill * frameBytes) != 0) {
+        atomic_store(&w->failed, 1);
+        break;
+      }
+      w->dataBytes += fill * frameBytes;
+      fill = 0;
+    }
+    if (n == 0) {
+      if (!running) break;
+      sleepNanoseconds(1000000);  // ring is empty, wait for the producer
+    }
+  }
+
+  return NULL;
+}
+
+int wavWriterOpen(wavwriter *w, const char *path, int channelCount,
+                  double sampleRate, double ringSeconds) {
+  unsigned char header[HEADER_BYTES];
+
+  memset(w, 0, sizeof(*w));
+  w->channelCount = channelCount;
+  w->sampleRate = sampleRate;
+  atomic_init(&w->running, 1);
+  atomic_init(&w->failed, 0);
+  atomic_init(&w->droppedFrames, 0);
+
+  w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (w->fd < 0) return -1;
+  buildHeader(header, w, 0);
+  if (writeAll(w->fd, (const char *)header, HEADER_BYTES) != 0) goto error;
+
+  if (ringBufferInit(&w->ring, channelCount * sizeof(float),
+                     (size_t)(ringSeconds * sampleRate)) != 0)
+    goto error;
+  w->block = malloc(WAVWRITER_BLOCK_BYTES);
+  if (w->block == NULL) goto error;
+  if (pthread_create(&w->thread, NULL, writerThread, w) != 0) goto error;
+
+  return 0;
+
+error:
+  free(w->block);
+  ringBufferFree(&w->ring);
+  close(w->fd);
+  return -1;
+}
+
+unsigned long wavWriterWrite(wavwriter *w, const float *frames,
+                             unsigned long count) {
+  unsigned long n = ringBufferWrite(&w->ring, frames, count);
+
+  if (n < count) atomic_fetch_add(&w->droppedFrames, count - n);
+  return n;
+}
+
+int wavWriterClose(wavwriter *w) {
+  unsigned char header[HEADER_BYTES];
+  int result;
+
+  atomic_store(&w->running, 0);
+  pthread_join(w->thread, NULL);
+  result = atomic_load(&w->failed) ? -1 : 0;
+
+  buildHeader(header, w, w->dataBytes);
+  if (pwrite(w->fd, header, HEADER_BYTES, 0) != HEADER_BYTES) result = -1;
+  if (close(w->fd) != 0) result = -1;
+  free(w->block);
+  ringBufferFree(&w->ring);
+
+  return result;
+}
+
+int wavWriterSink(const float *buffer, unsigned long frames, int channelCount,
+                  void *sinkData) {
+  wavwriter *w = (wavwriter *)sinkData;
+  unsigned long n;
+
+  if (channelCount != w->channelCount) return -1;
+  while (frames > 0) {
+    n = ringBufferWrite(&w->ring, buffer, frames);
+    buffer += n * channelCount;
+    frames -= n;
+    if (frames > 0) {
+      if (atomic_load(&w->failed)) return -1;
+      sleepNanoseconds(100000);  // disk is behind, offline renders may wait
+    }
+  }
+
+  return 0;
+}
+
+int wavTapCallback(const void *inputBuffer, void *outputBuffer,
+                   unsigned long framesPerBuffer,
+                   const PaStreamCallbackTimeInfo *timeInfo,
+                   PaStreamCallbackFlags statusFlags, void *userData) {
+  wavtap *tap = (wavtap *)userData;
+  int result = tap->callback(inputBuffer, outputBuffer, framesPerBuffer,
+                             timeInfo, statusFlags, tap->userData);
+
+  wavWriterWrite(tap->writer, (const float *)outputBuffer, framesPerBuffer);
+  return result;
+}
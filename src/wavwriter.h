@@ -0,0 +1,65 @@
+/**
+ *  Purpose:
+ *    streaming 32-bit float WAV / RF64 writer for rendered output
+ *
+ *  wavwriter.h
+ *
+ *  Interleaved float frames are queued through a lock-free ring buffer and
+ *  written to disk by a separate thread in large blocks, so a stalled disk
+ *  never blocks the audio callback. The header reserves room for an RF64
+ *  ds64 chunk (EBU Tech 3306); if the file grows past the 4 GB RIFF limit
+ *  it is rewritten as RF64 when the writer is closed, otherwise it stays a
+ *  plain WAVE_FORMAT_IEEE_FLOAT file.
+ */
+
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "portaudio.h"
+#include "ringbuffer.h"
+
+#define WAVWRITER_BLOCK_BYTES (4 << 20)  // bytes per write(2) call
+
+typedef struct {
+  int fd;
+  int channelCount;
+  double sampleRate;
+  ringbuffer ring;                      // one element per interleaved frame
+  char *block;                          // staging buffer for large writes
+  pthread_t thread;
+  atomic_int running;
+  atomic_int failed;                    // set by the disk thread on error
+  atomic_ullong droppedFrames;          // frames lost to a full ring
+  unsigned long long dataBytes;         // sample bytes on disk
+} wavwriter;
+
+// ringSeconds of audio are buffered between the producer and the disk
+int wavWriterOpen(wavwriter *w, const char *path, int channelCount,
+                  double sampleRate, double ringSeconds);
+// real-time safe: never blocks, frames that do not fit are dropped and
+// counted; returns the number of frames queued
+unsigned long wavWriterWrite(wavwriter *w, const float *frames,
+                             unsigned long count);
+// drain the ring, stop the thread and finalize the header, 0 on success
+int wavWriterClose(wavwriter *w);
+
+// nullDeviceSink adapter with sinkData a wavwriter *: offline renders wait
+// for ring space instead of dropping frames
+int wavWriterSink(const float *buffer, unsigned long frames, int channelCount,
+                  void *sinkData);
+
+// wraps a stream callback and records everything it plays
+typedef struct {
+  PaStreamCallback *callback;
+  void *userData;
+  wavwriter *writer;
+} wavtap;
+
+int wavTapCallback(const void *inputBuffer, void *outputBuffer,
+                   unsigned long framesPerBuffer,
+                   const PaStreamCallbackTimeInfo *timeInfo,
+                   PaStreamCallbackFlags statusFlags, void *userData);
+
+#endif  // WAVWRITER_H
@@ -0,0 +1,222 @@
+/**
+ *  Purpose:
+ *    real-time safe worker pool, see workerpool.h
+ *
+ *  workerpool.c
+ *
+ *  Off Linux there is no futex and no pinning: idle workers spin, then
+ *  yield the processor until the next batch.
+ */
+
+#define _GNU_SOURCE
+
+#include "workerpool.h"
+
+#include <limits.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+// a pause between polls, which frees the core's resources for its
+// hyperthread sibling
+static inline void cpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+// sleep while *word still holds value
+static void futexWait(atomic_uint *word, unsigned value) {
+#if defined(__linux__)
+  syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+  if (atomic_load(word) == value) sched_yield();
+#endif
+}
+
+static void futexWakeAll(atomic_uint *word) {
+#if defined(__linux__)
+  syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+static unsigned long long packRange(unsigned batch, int first, int end) {
+  return (unsigned long long)batch << 32 | (unsigned long long)first << 16 |
+         (unsigned long long)end;
+}
+
+// take a task of batch from range r, its front for the owner and its back
+// for a thief; -1 when it is empty or belongs to another batch
+static int takeTask(workerrange *r, unsigned batch, int steal) {
+  unsigned long long word = atomic_load_explicit(&r->tasks,
+                                                 memory_order_acquire);
+  int first, end;
+
+  for (;;) {
+    first = (int)(word >> 16 & 0xFFFF);
+    end = (int)(word & 0xFFFF);
+    if ((unsigned)(word >> 32) != batch || first >= end) return -1;
+    if (atomic_compare_exchange_weak_explicit(
+            &r->tasks, &word,
+            steal ? packRange(batch, first, end - 1)
+                  : packRange(batch, first + 1, end),
+            memory_order_acq_rel, memory_order_acquire))
+      return steal ? end - 1 : first;
+  }
+}
+
+// run thread self's range, then steal from the others until none are left
+static void runTasks(workerpool *pool, int self, unsigned batch) {
+  const int threads = pool->threadCount + 1;
+  int task, victim, k;
+
+  for (;;) {
+    task = takeTask(&pool->range[self], batch, 0);
+    // nearest neighbour first, so thieves spread over the victims
+    for (k = 1; task < 0 && k < threads; k++) {
+      victim = (self + k) % threads;
+      task = takeTask(&pool->range[victim], batch, 1);
+    }
+    if (task < 0) return;
+    pool->task(pool->data, task);
+    atomic_fetch_sub_explicit(&pool->remaining, 1, memory_order_release);
+  }
+}
+
+static void *workerMain(void *arg) {
+  workerthread *w = (workerthread *)arg;
+  workerpool *pool = w->pool;
+  // the batch the pool was made with, not the one when this thread got to
+  // run: a batch or the stop published in between must not look seen
+  unsigned seen = 0, now;
+  int spin;
+
+  for (;;) {
+    now = atomic_load_explicit(&pool->batch, memory_order_acquire);
+    for (spin = 0; spin < pool->spin && now == seen; spin++) {
+      cpuRelax();
+      now = atomic_load_explicit(&pool->batch, memory_order_acquire);
+    }
+    if (now == seen) {
+      // the caller wakes only if it sees a sleeper, and a sleeper only
+      // waits if it has not seen the new batch, both sequentially
+      // consistent, so no wake up is lost
+      atomic_fetch_add(&pool->sleeping, 1);
+      futexWait(&pool->batch, seen);
+      atomic_fetch_sub(&pool->sleeping, 1);
+      continue;
+    }
+    seen = now;
+    if (atomic_load(&pool->stopping)) break;
+    runTasks(pool, w->index, seen);
+  }
+  return NULL;
+}
+
+static void pinThread(workerthread *w) {
+#if defined(__linux__)
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  CPU_SET(w->cpu, &set);
+  if (pthread_setaffinity_np(w->thread, sizeof(set), &set) != 0) w->cpu = -1;
+#else
+  w->cpu = -1;
+#endif
+}
+
+int workerPoolInit(workerpool *pool, int threads, const int *cpus) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  int i;
+
+  memset(pool, 0, sizeof(*pool));
+  atomic_init(&pool->batch, 0);
+  atomic_init(&pool->remaining, 0);
+  atomic_init(&pool->sleeping, 0);
+  atomic_init(&pool->stopping, 0);
+  for (i = 0; i <= WORKERPOOL_MAX_THREADS; i++)
+    atomic_init(&pool->range[i].tasks, 0);
+  if (threads < 0 || threads > WORKERPOOL_MAX_THREADS) return -1;
+  if (cores < 1) cores = 1;
+  pool->spin = threads < cores ? WORKERPOOL_SPIN : 0;
+
+  for (i = 0; i < threads; i++) {
+    workerthread *w = &pool->workers[i];
+
+    w->pool = pool;
+    w->index = i + 1;
+    w->cpu = cpus != NULL ? cpus[i] : (int)((i + 1) % cores);
+    if (pthread_create(&w->thread, NULL, workerMain, w) != 0) {
+      workerPoolFree(pool);
+      return -1;
+    }
+    pool->threadCount++;
+    pinThread(w);
+  }
+  return 0;
+}
+
+void workerPoolFree(workerpool *pool) {
+  int i;
+
+  atomic_store(&pool->stopping, 1);
+  atomic_fetch_add(&pool->batch, 1);
+  futexWakeAll(&pool->batch);
+  for (i = 0; i < pool->threadCount; i++)
+    pthread_join(pool->workers[i].thread, NULL);
+  pool->threadCount = 0;
+}
+
+int workerPoolPin(workerpool *pool, const int *cpus, int count) {
+  int i, pinned = 0;
+
+  for (i = 0; i < pool->threadCount && count > 0; i++) {
+    pool->workers[i].cpu = cpus[i % count];
+    pinThread(&pool->workers[i]);
+    if (pool->workers[i].cpu >= 0) pinned++;
+  }
+  return pinned;
+}
+
+void workerPoolRun(workerpool *pool, workertask task, void *data, int tasks) {
+  const int threads = pool->threadCount + 1;
+  unsigned batch;
+  int t;
+
+  if (tasks > WORKERPOOL_MAX_TASKS) tasks = WORKERPOOL_MAX_TASKS;
+  if (threads == 1 || tasks < 2) {
+    for (t = 0; t < tasks; t++) task(data, t);
+    return;
+  }
+
+  // every range of the last batch is empty, so no worker is still taking
+  // from them and the batch can be set up in place
+  batch = atomic_load_explicit(&pool->batch, memory_order_relaxed) + 1;
+  pool->task = task;
+  pool->data = data;
+  atomic_store_explicit(&pool->remaining, tasks, memory_order_relaxed);
+  for (t = 0; t < threads; t++)
+    atomic_store_explicit(
+        &pool->range[t].tasks,
+        packRange(batch, tasks * t / threads, tasks * (t + 1) / threads),
+        memory_order_relaxed);
+  atomic_store(&pool->batch, batch);
+  if (atomic_load(&pool->sleeping) > 0) futexWakeAll(&pool->batch);
+
+  runTasks(pool, 0, batch);
+  // the last tasks may still be running on the workers; yield now and
+  // then in case one of them was preempted on this core
+  for (t = 1;
+       atomic_load_explicit(&pool->remaining, memory_order_acquire) > 0; t++)
+    if (t % WORKERPOOL_SPIN == 0)
+      sched_yield();
+    else
+      cpuRelax();
+}
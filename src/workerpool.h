@@ -0,0 +1,83 @@
+/**
+ *  Purpose:
+ *    real-time safe worker threads that share the audio callback's work
+ *
+ *  workerpool.h
+ *
+ *  A fork-join pool for the callback thread: workerPoolRun hands a batch
+ *  of numbered tasks to the workers, runs its own share, and returns once
+ *  every task is done. The tasks are dealt out as contiguous ranges, one
+ *  per thread, caller included. A thread takes tasks from the front of its
+ *  own range and, when that is empty, steals from the back of the others,
+ *  so a few expensive tasks do not leave the other cores idle. A range is
+ *  a single 64-bit word updated by compare and swap, tagged with the batch
+ *  it belongs to, so a late worker never takes a task of the next batch.
+ *
+ *  Idle workers spin for WORKERPOOL_SPIN rounds, catching the sub-blocks
+ *  a scheduler splits a buffer into, then sleep on a futex; with more
+ *  threads than cores they sleep at once, since a spinning worker (at
+ *  SCHED_FIFO especially, see rtsetup.h) would hold up the others. The caller
+ *  only makes the wake system call when a worker is asleep; nothing on
+ *  the run path allocates, locks or blocks. Worker threads are pinned to
+ *  one core each where the platform allows it (Linux).
+ *
+ *  Which thread runs a task is not deterministic, so tasks must write to
+ *  their own outputs and the caller combines them in task order after
+ *  workerPoolRun, which makes the result independent of the thread count.
+ */
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define WORKERPOOL_MAX_THREADS 16  // workers, besides the calling thread
+#define WORKERPOOL_MAX_TASKS 65535
+#define WORKERPOOL_SPIN 20000  // polls of an idle worker before it sleeps
+
+// runs task number task of a batch, on any thread
+typedef void (*workertask)(void *data, int task);
+
+typedef struct workerpool workerpool;
+
+typedef struct {
+  workerpool *pool;
+  int index;  // 1 to threadCount, the caller is 0
+  int cpu;    // pinned to, or -1
+  pthread_t thread;
+} workerthread;
+
+// the tasks left to a thread, batch << 32 | first << 16 | end, a cache
+// line each
+typedef struct {
+  _Alignas(64) atomic_ullong tasks;
+} workerrange;
+
+struct workerpool {
+  workerthread workers[WORKERPOOL_MAX_THREADS];
+  int threadCount;
+  int spin;  // polls before sleeping, WORKERPOOL_SPIN or 0
+
+  // the batch being run, valid while its tasks are outstanding
+  workertask task;
+  void *data;
+  workerrange range[WORKERPOOL_MAX_THREADS + 1];  // per thread
+  _Alignas(64) atomic_uint batch;  // counts batches, wakes the workers
+  _Alignas(64) atomic_int remaining;  // tasks not finished yet
+  _Alignas(64) atomic_int sleeping;   // workers waiting on the futex
+  atomic_int stopping;
+};
+
+// starts threads workers (0 runs everything on the caller), pinning worker
+// i to cpus[i - 1], or to core i when cpus is NULL; returns 0 on success
+int workerPoolInit(workerpool *pool, int threads, const int *cpus);
+// stops and joins the workers
+void workerPoolFree(workerpool *pool);
+// moves worker i to cpus[(i - 1) % count], returns how many were pinned
+int workerPoolPin(workerpool *pool, const int *cpus, int count);
+// runs task(data, 0) to task(data, tasks - 1) and returns when all are done,
+// from one thread at a time
+void workerPoolRun(workerpool *pool, workertask task, void *data, int tasks);
+
+#endif  // WORKERPOOL_H
@@ -0,0 +1,251 @@
+/**
+ *  Purpose:
+ *    the graph compiler: rejected graphs, and buffer reuse that never
+ *    overwrites a buffer still to be read
+ *
+ *  graphtest.c
+ *
+ *  Random acyclic graphs are compiled and their schedules checked step by
+ *  step, then rendered and compared with a plain evaluation that gives
+ *  every node a buffer of its own.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "graph.h"
+#include "tests.h"
+
+#define GRAPHS 200
+#define NODES 24
+#define FRAMES 300  // more than a GRAPH_BLOCK, so state carries over
+
+static graph g;
+static float reference[GRAPH_MAX_NODES][2 * FRAMES];
+static float out[2 * FRAMES];
+static float sourceValue[GRAPH_MAX_NODES];
+static unsigned long sinkFrames;
+
+// a source without state, so the reference can call it again
+static int testSource(const void *inputBuffer, void *outputBuffer,
+                      unsigned long framesPerBuffer,
+                      const PaStreamCallbackTimeInfo *timeInfo,
+                      PaStreamCallbackFlags statusFlags, void *userData) {
+  const float value = *(const float *)userData;
+  float *buffer = (float *)outputBuffer;
+  unsigned long i;
+
+  for (i = 0; i < 2 * framesPerBuffer; i++)
+    buffer[i] = value * (float)(1 + i % 7) - (float)(i & 1);
+  return paContinue;
+}
+
+static int countSink(const float *buffer, unsigned long frames,
+                     int channelCount, void *sinkData) {
+  sinkFrames += frames;
+  return 0;
+}
+
+static unsigned long nextRandom(unsigned long *state) {
+  *state = *state * 6364136223846793005ul + 1442695040888963407ul;
+  return *state >> 33;
+}
+
+static void rejected(void) {
+  int s, m, f;
+
+  // a loop through a mixer
+  graphInit(&g, 48000.);
+  s = graphAddSource(&g, testSource, &sourceValue[0]);
+  m = graphAddMixer(&g);
+  f = graphAddFilter(&g, FILTER_LOWPASS, 1000., .7);
+  CHECK(graphConnect(&g, s, m, 1.f) == 0);
+  CHECK(graphConnect(&g, m, f, 1.f) == 0);
+  CHECK(graphConnect(&g, f, m, .5f) == 0);
+  graphSetOutput(&g, f);
+  CHECK(graphCompile(&g) == -1);
+  CHECK(g.stepCount == 0);
+
+  // a filter feeding itself
+  graphInit(&g, 48000.);
+  f = graphAddFilter(&g, FILTER_LOWPASS, 1000., .7);
+  CHECK(graphConnect(&g, f, f, 1.f) == 0);
+  graphSetOutput(&g, f);
+  CHECK(graphCompile(&g) == -1);
+
+  // a needed mixer without inputs, and no output at all
+  graphInit(&g, 48000.);
+  m = graphAddMixer(&g);
+  CHECK(graphCompile(&g) == -1);
+  graphSetOutput(&g, m);
+  CHECK(graphCompile(&g) == -1);
+
+  // sinks produce nothing to connect
+  graphInit(&g, 48000.);
+  s = graphAddSource(&g, testSource, &sourceValue[0]);
+  f = graphAddSink(&g, countSink, NULL);
+  CHECK(graphConnect(&g, s, f, 1.f) == 0);
+  CHECK(graphConnect(&g, f, s, 1.f) == -1);
+  CHECK(graphConnect(&g, s, f, 1.f) == -1);  // one input only
+}
+
+// nodes ordered by a random rank, each fed only by lower ranks, so the
+// graph is acyclic but the compiler cannot just take the nodes in order
+static int randomGraph(unsigned long *seed) {
+  int rank[NODES], byRank[NODES], n, k, j, t, inputs, from, output = -1;
+
+  for (n = 0; n < NODES; n++) byRank[n] = n;
+  for (n = NODES - 1; n > 0; n--) {
+    k = (int)(nextRandom(seed) % (n + 1));
+    t = byRank[n], byRank[n] = byRank[k], byRank[k] = t;
+  }
+  for (n = 0; n < NODES; n++) rank[byRank[n]] = n;
+
+  graphInit(&g, 48000.);
+  for (n = 0; n < NODES; n++) {
+    t = rank[n] < 2 ? 0 : (int)(nextRandom(seed) % 8);
+    sourceValue[n] = .1f * (n + 1);
+    if (t == 0)
+      graphAddSource(&g, testSource, &sourceValue[n]);
+    else if (t < 4)
+      graphAddFilter(&g, (filtertype)(t - 1), 200. + 100. * n, .7);
+    else if (t < 7)
+      graphAddMixer(&g);
+    else
+      graphAddSink(&g, countSink, NULL);
+  }
+  for (n = 0; n < NODES; n++) {
+    if (g.nodes[n].type == GRAPH_SOURCE) continue;
+    inputs = g.nodes[n].type == GRAPH_MIXER
+                 ? 1 + (int)(nextRandom(seed) % 4)
+                 : 1;
+    for (j = 0; j < inputs; j++) {
+      // any lower ranked node that has an output, repeats allowed
+      do {
+        from = byRank[nextRandom(seed) % rank[n]];
+      } while (g.nodes[from].type == GRAPH_SINK);
+      CHECK(graphConnect(&g, from, n, .5f + .25f * j) == 0);
+    }
+    if (g.nodes[n].type != GRAPH_SINK &&
+        (output < 0 || rank[n] > rank[output]))
+      output = n;
+  }
+  graphSetOutput(&g, output);
+  return output;
+}
+
+// every step reads buffers its inputs wrote and are not yet overwritten,
+// and writes one nothing live occupies but possibly its first input
+static void checkSchedule(int output) {
+  int stepOf[GRAPH_MAX_NODES], lastRead[GRAPH_MAX_NODES];
+  const float *bufferOf[GRAPH_MAX_NODES];
+  const graphnode *node;
+  int p, q, k, n, inPlace;
+
+  for (n = 0; n < GRAPH_MAX_NODES; n++) stepOf[n] = lastRead[n] = -1;
+  for (p = 0; p < g.stepCount; p++) {
+    node = g.steps[p].node;
+    n = (int)(node - g.nodes);
+    stepOf[n] = p;
+    bufferOf[n] = g.steps[p].out;
+    CHECK((node->type == GRAPH_SINK) == (g.steps[p].out == NULL));
+    CHECK(g.steps[p].out == NULL ||
+          (g.steps[p].out >= g.buffer[0] &&
+           g.steps[p].out < g.buffer[g.bufferCount]));
+    for (k = 0; k < node->inputCount; k++) {
+      // inputs come first in the schedule and are read where they wrote
+      CHECK(stepOf[node->inputs[k]] >= 0);
+      if (stepOf[node->inputs[k]] < 0) return;
+      CHECK(g.steps[p].in[k] == bufferOf[node->inputs[k]]);
+      lastRead[node->inputs[k]] = p;
+    }
+  }
+  CHECK(stepOf[output] >= 0);
+  if (stepOf[output] < 0) return;
+  lastRead[output] = g.stepCount;  // played after the last step
+  CHECK(g.result == bufferOf[output]);
+
+  for (p = 0; p < g.stepCount; p++) {
+    if (g.steps[p].out == NULL) continue;
+    node = g.steps[p].node;
+    for (q = 0; q < p; q++) {
+      n = (int)(g.steps[q].node - g.nodes);
+      if (g.steps[q].out != g.steps[p].out || lastRead[n] < p) continue;
+      // still live: only the last reader may overwrite it, and only as its
+      // first and only use of it
+      inPlace = lastRead[n] == p && node->inputs[0] == n;
+      for (k = 1; k < node->inputCount; k++)
+        if (node->inputs[k] == n) inPlace = 0;
+      CHECK(inPlace);
+    }
+  }
+}
+
+// every node in a buffer of its own, in schedule order
+static void renderReference(void) {
+  PaStreamCallbackTimeInfo timeInfo = {0, 0, 0};
+  float z1[GRAPH_MAX_NODES][2], z2[GRAPH_MAX_NODES][2];
+  const graphnode *f;
+  float x, y, *r;
+  unsigned long i, start, n;
+  int p, k, c, node;
+
+  memset(z1, 0, sizeof(z1));
+  memset(z2, 0, sizeof(z2));
+  for (start = 0; start < FRAMES; start += n) {
+    n = FRAMES - start < GRAPH_BLOCK ? FRAMES - start : GRAPH_BLOCK;
+    for (p = 0; p < g.stepCount; p++) {
+      f = g.steps[p].node;
+      node = (int)(f - g.nodes);
+      r = reference[node] + 2 * start;
+      if (f->type == GRAPH_SOURCE) {
+        f->callback(NULL, r, n, &timeInfo, 0, f->userData);
+      } else if (f->type == GRAPH_FILTER) {
+        for (c = 0; c < 2; c++)
+          for (i = c; i < 2 * n; i += 2) {
+            x = reference[f->inputs[0]][2 * start + i];
+            y = f->b0 * x + z1[node][c];
+            z1[node][c] = f->b1 * x - f->a1 * y + z2[node][c];
+            z2[node][c] = f->b2 * x - f->a2 * y;
+            r[i] = y;
+          }
+      } else if (f->type == GRAPH_MIXER) {
+        for (i = 0; i < 2 * n; i++) {
+          r[i] = f->gain[0] * reference[f->inputs[0]][2 * start + i];
+          for (k = 1; k < f->inputCount; k++)
+            r[i] += f->gain[k] * reference[f->inputs[k]][2 * start + i];
+        }
+      }
+    }
+  }
+}
+
+void testGraph(void) {
+  PaStreamCallbackTimeInfo timeInfo = {0, 0, 0};
+  unsigned long seed = 1, sinks, i;
+  int graphs, output, n, worst = 0, bad;
+
+  rejected();
+  for (graphs = 0; graphs < GRAPHS; graphs++) {
+    output = randomGraph(&seed);
+    CHECK(graphCompile(&g) == 0);
+    checkSchedule(output);
+
+    CHECK(g.bufferCount <= g.stepCount);
+    if (g.bufferCount > worst) worst = g.bufferCount;
+
+    // the schedule computes what every node computes on its own
+    for (n = 0, sinks = 0; n < g.stepCount; n++)
+      if (g.steps[n].node->type == GRAPH_SINK) sinks++;
+    sinkFrames = 0;
+    CHECK(graphCallback(NULL, out, FRAMES, &timeInfo, 0, &g) == paContinue);
+    CHECK(sinkFrames == sinks * FRAMES);
+    renderReference();
+    for (i = 0, bad = 0; i < 2 * FRAMES; i++)
+      if (!(fabsf(out[i] - reference[output][i]) <=
+            1e-5f * (1.f + fabsf(reference[output][i]))))
+        bad++;
+    CHECK(bad == 0);
+  }
+  printf("graph: %d graphs of %d nodes, at most %d buffers\n", GRAPHS, NODES,
+         worst);
+}
@@ -0,0 +1,107 @@
+/**
+ *  Purpose:
+ *    every SIMD kernel this CPU runs against the scalar one
+ *
+ *  osckerneltest.c
+ *
+ *  The kernels evaluate the same expressions in the same order, but the
+ *  compiler may contract the scalar one into fused multiply-adds (e.g.
+ *  with -march=native), so samples are compared to within a few units in
+ *  the last place; phases are integers and must match exactly.
+ */
+
+#include <math.h>
+#include "builtin.h"
+#include "osckernel.h"
+#include "tests.h"
+
+#define FRAMES 1003  // not a multiple of any vector width
+#define TOLERANCE 1e-6f
+
+static const uint32_t increments[] = {0, 1, 0x00A3D70A, 0x1234567,
+                                      0x7FFFFFFF, 0xC0000001};
+
+// samples further apart than tolerance, NaNs included
+static int mismatches(const float *a, const float *b, int count,
+                      float tolerance) {
+  int i, n = 0;
+
+  for (i = 0; i < count; i++)
+    if (!(fabsf(a[i] - b[i]) <= tolerance)) n++;
+  return n;
+}
+
+static void compareRender(const osckernel *scalar, const osckernel *k,
+                          const float *table, const float *next) {
+  static float expected[2 * FRAMES], actual[2 * FRAMES];
+  const int n = sizeof(increments) / sizeof(increments[0]);
+  uint32_t p0, p1;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    p0 = p1 = 0x89ABCDEFu * (uint32_t)i;
+    scalar->render(table, BUILTIN_TABLE_BITS, &p0, increments[i], .7f,
+                   expected, FRAMES);
+    k->render(table, BUILTIN_TABLE_BITS, &p1, increments[i], .7f, actual,
+              FRAMES);
+    CHECK(p0 == p1);
+    CHECK(mismatches(expected, actual, 2 * FRAMES, TOLERANCE) == 0);
+
+    // a morph across the whole crossfade, and one standing still
+    p0 = p1 = 0x89ABCDEFu * (uint32_t)i;
+    scalar->morph(table, next, BUILTIN_TABLE_BITS, &p0, increments[i], .7f,
+                  0.f, 1.f / FRAMES, expected, FRAMES);
+    k->morph(table, next, BUILTIN_TABLE_BITS, &p1, increments[i], .7f, 0.f,
+             1.f / FRAMES, actual, FRAMES);
+    CHECK(p0 == p1);
+    CHECK(mismatches(expected, actual, 2 * FRAMES, TOLERANCE) == 0);
+    scalar->morph(table, next, BUILTIN_TABLE_BITS, &p0, increments[i], .7f,
+                  .25f, 0.f, expected, FRAMES);
+    k->morph(table, next, BUILTIN_TABLE_BITS, &p1, increments[i], .7f, .25f,
+             0.f, actual, FRAMES);
+    CHECK(p0 == p1);
+    CHECK(mismatches(expected, actual, 2 * FRAMES, TOLERANCE) == 0);
+  }
+}
+
+static void compareUnison(const osckernel *scalar, const osckernel *k,
+                          const float *table) {
+  static float expected[2 * FRAMES], actual[2 * FRAMES];
+  uint32_t p0[OSC_UNISON_MAX], p1[OSC_UNISON_MAX], inc[OSC_UNISON_MAX];
+  float left[OSC_UNISON_MAX], right[OSC_UNISON_MAX];
+  int copies, c;
+
+  for (copies = 8; copies <= OSC_UNISON_MAX; copies += 8) {
+    for (c = 0; c < copies; c++) {
+      p0[c] = p1[c] = 0x9E3779B9u * (uint32_t)c;
+      inc[c] = 0x00A3D70A + 0x3F00u * (uint32_t)c;
+      left[c] = (float)c / copies;
+      right[c] = 1.f - left[c];
+    }
+    scalar->unison(table, BUILTIN_TABLE_BITS, p0, inc, left, right, copies,
+                   expected, FRAMES);
+    k->unison(table, BUILTIN_TABLE_BITS, p1, inc, left, right, copies,
+              actual, FRAMES);
+    for (c = 0; c < copies; c++) CHECK(p0[c] == p1[c]);
+    // a sum over the copies, added up in another order
+    CHECK(mismatches(expected, actual, 2 * FRAMES, copies * TOLERANCE) ==
+          0);
+  }
+}
+
+void testOscKernels(void) {
+  const osckernel *kernels;
+  const float *sine = builtinSine();
+  mipmap saw;
+  int count, k;
+
+  builtinMipmap(&saw, WAVEFORM_SAW);
+  kernels = oscKernelList(&count);
+  CHECK(count >= 1);
+  for (k = 1; k < count; k++) {
+    printf("osckernel: %s against %s\n", kernels[k].name, kernels[0].name);
+    compareRender(&kernels[0], &kernels[k], sine, saw.level[0]);
+    compareRender(&kernels[0], &kernels[k], saw.level[0], sine);
+    compareUnison(&kernels[0], &kernels[k], saw.level[0]);
+  }
+}
@@ -0,0 +1,80 @@
+/**
+ *  Purpose:
+ *    the ring buffer filling up and wrapping around its end
+ *
+ *  ringbuffertest.c
+ */
+
+#include <stdint.h>
+#include "ringbuffer.h"
+#include "tests.h"
+
+// write count values from next on, return the next value
+static int writeValues(ringbuffer *rb, int next, size_t count) {
+  int values[16];
+  size_t i;
+
+  for (i = 0; i < count; i++) values[i] = next + (int)i;
+  CHECK(ringBufferWrite(rb, values, count) == count);
+  return next + (int)count;
+}
+
+// read count values, which must run on from next, return the next value
+static int readValues(ringbuffer *rb, int next, size_t count) {
+  int values[16];
+  size_t i;
+
+  CHECK(ringBufferRead(rb, values, count) == count);
+  for (i = 0; i < count; i++) CHECK(values[i] == next + (int)i);
+  return next + (int)count;
+}
+
+static void fillAndWrap(ringbuffer *rb) {
+  int values[16] = {0}, written = 0, read = 0;
+  void *data1, *data2;
+  size_t size1, size2, first;
+
+  // full: nothing more goes in and nothing is overwritten
+  written = writeValues(rb, written, 8);
+  CHECK(ringBufferWriteAvailable(rb) == 0);
+  CHECK(ringBufferWrite(rb, values, 1) == 0);
+  CHECK(ringBufferReadAvailable(rb) == 8);
+  read = readValues(rb, read, 5);
+
+  // 5 more, so the 8 readable ones run past the end of the array: the
+  // first region ends there and the second starts at the front
+  written = writeValues(rb, written, 5);
+  CHECK(ringBufferReadAvailable(rb) == 8);
+  first = atomic_load(&rb->readIndex) & rb->mask;
+  CHECK(ringBufferGetReadRegions(rb, 8, &data1, &size1, &data2, &size2) ==
+        8);
+  CHECK(first > 0 && size1 == 8 - first && size2 == first);
+  CHECK(data1 == rb->data + first * sizeof(int) && data2 == rb->data);
+  CHECK(((int *)data1)[0] == read && ((int *)data2)[0] == read + (int)size1);
+  read = readValues(rb, read, 8);
+  CHECK(ringBufferReadAvailable(rb) == 0);
+  CHECK(ringBufferRead(rb, values, 1) == 0);
+
+  // a partial write takes what fits
+  CHECK(ringBufferWrite(rb, values, 12) == 8);
+  CHECK(ringBufferWriteAvailable(rb) == 0);
+}
+
+void testRingBuffer(void) {
+  ringbuffer rb;
+
+  // the capacity is rounded up to a power of two
+  CHECK(ringBufferInit(&rb, sizeof(int), 5) == 0);
+  CHECK(rb.capacity == 8);
+  fillAndWrap(&rb);
+  ringBufferFree(&rb);
+
+  // the same across the overflow of the free running counters
+  CHECK(ringBufferInit(&rb, sizeof(int), 8) == 0);
+  atomic_store(&rb.writeIndex, SIZE_MAX - 2);
+  atomic_store(&rb.readIndex, SIZE_MAX - 2);
+  CHECK(ringBufferReadAvailable(&rb) == 0);
+  CHECK(ringBufferWriteAvailable(&rb) == 8);
+  fillAndWrap(&rb);
+  ringBufferFree(&rb);
+}
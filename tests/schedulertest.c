@@ -0,0 +1,104 @@
+/**
+ *  Purpose:
+ *    the scheduler handing out events in order, each on its frame
+ *
+ *  schedulertest.c
+ */
+
+#include "scheduler.h"
+#include "tests.h"
+
+#define BLOCK 256
+#define MAX_LOG 32
+
+// what the callback and the handler saw, in order
+typedef struct {
+  scheduler *s;
+  unsigned long pieces[MAX_LOG];  // frames of each callback piece
+  unsigned long long pieceStart[MAX_LOG];
+  int pieceCount;
+  int keys[MAX_LOG];  // events handled, by key
+  unsigned long long handledAt[MAX_LOG];  // frame the scheduler was at
+  int eventCount;
+} schedulerlog;
+
+static int logPiece(const void *inputBuffer, void *outputBuffer,
+                    unsigned long framesPerBuffer,
+                    const PaStreamCallbackTimeInfo *timeInfo,
+                    PaStreamCallbackFlags statusFlags, void *userData) {
+  schedulerlog *log = (schedulerlog *)userData;
+  float *out = (float *)outputBuffer;
+  unsigned long i;
+
+  if (log->pieceCount < MAX_LOG) {
+    log->pieces[log->pieceCount] = framesPerBuffer;
+    log->pieceStart[log->pieceCount++] = log->s->frame;
+  }
+  for (i = 0; i < 2 * framesPerBuffer; i++) out[i] = (float)log->eventCount;
+  return paContinue;
+}
+
+static void logEvent(const event *e, void *userData) {
+  schedulerlog *log = (schedulerlog *)userData;
+
+  if (log->eventCount < MAX_LOG) {
+    log->keys[log->eventCount] = e->key;
+    log->handledAt[log->eventCount++] = log->s->frame;
+  }
+}
+
+static void send(scheduler *s, unsigned long long frame, int key) {
+  event e = {0};
+
+  e.frame = frame;
+  e.type = EVENT_PARAM;
+  e.key = key;
+  CHECK(schedulerSend(s, &e) == 0);
+}
+
+void testScheduler(void) {
+  static scheduler s;
+  static float out[2 * BLOCK];
+  PaStreamCallbackTimeInfo timeInfo = {0, 0, 0};
+  schedulerlog log = {0};
+  static const unsigned long pieces[] = {100, 156, 44, 212, 188, 68, 256};
+  static const int keys[] = {1, 2, 3, 4, 5};
+  static const unsigned long long handledAt[] = {100, 100, 300, 700, 700};
+  int k;
+
+  log.s = &s;
+  CHECK(schedulerInit(&s, logPiece, &log, logEvent, 2, 44100.) == 0);
+  // out of order, the two at 100 and the two at 700 in the order sent
+  send(&s, 700, 4);
+  send(&s, 100, 1);
+  send(&s, 300, 3);
+  send(&s, 100, 2);
+  send(&s, 700, 5);
+
+  for (k = 0; k < 4; k++) {
+    CHECK(schedulerCallback(NULL, out, BLOCK, &timeInfo, 0, &s) ==
+          paContinue);
+    timeInfo.outputBufferDacTime += BLOCK / 44100.;
+  }
+  // blocks split at 100, 300 and 700, never anywhere else
+  CHECK(log.pieceCount == 7);
+  for (k = 0; k < 7 && k < log.pieceCount; k++)
+    CHECK(log.pieces[k] == pieces[k]);
+  CHECK(log.pieceStart[2] == 256 && log.pieceStart[4] == 512);
+  CHECK(log.eventCount == 5);
+  for (k = 0; k < 5 && k < log.eventCount; k++) {
+    CHECK(log.keys[k] == keys[k]);
+    CHECK(log.handledAt[k] == handledAt[k]);
+  }
+  // the last block came after every event, rendered in one piece
+  CHECK(out[0] == 5.f && out[2 * BLOCK - 1] == 5.f);
+
+  // an event already late lands at the start of the next block
+  send(&s, 10, 6);
+  CHECK(schedulerCallback(NULL, out, BLOCK, &timeInfo, 0, &s) ==
+        paContinue);
+  CHECK(log.eventCount == 6 && log.handledAt[5] == 4 * BLOCK);
+  CHECK(log.pieces[log.pieceCount - 1] == BLOCK);
+  CHECK(atomic_load(&s.dropped) == 0);
+  schedulerFree(&s);
+}
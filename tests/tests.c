@@ -0,0 +1,47 @@
+/**
+ *  Purpose:
+ *    runs the tests of libwavetable
+ *
+ *  usage:
+ *    tests [name]
+ *    runs the test of that name, or every test; the exit status is 0 when
+ *    all checks passed
+ *
+ *  tests.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests.h"
+
+int checkFailures = 0;
+
+static const struct {
+  const char *name;
+  void (*run)(void);
+} tests[] = {
+    {"ringbuffer", testRingBuffer}, {"scheduler", testScheduler},
+    {"wavwriter", testWavWriter},   {"osckernel", testOscKernels},
+    {"voicepool", testVoicePool},   {"graph", testGraph},
+    {"unison", testUnison},
+};
+
+int main(int argc, char *argv[]) {
+  const int count = sizeof(tests) / sizeof(tests[0]);
+  int k, ran = 0, before;
+
+  for (k = 0; k < count; k++) {
+    if (argc > 1 && strcmp(argv[1], tests[k].name) != 0) continue;
+    before = checkFailures;
+    tests[k].run();
+    printf("%s: %s\n", tests[k].name,
+           checkFailures == before ? "passed" : "FAILED");
+    ran++;
+  }
+  if (ran == 0) {
+    fprintf(stderr, "usage: %s [name], no test named %s\n", argv[0],
+            argv[1]);
+    return 1;
+  }
+  return checkFailures == 0 ? 0 : 1;
+}
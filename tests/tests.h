@@ -0,0 +1,37 @@
+/**
+ *  Purpose:
+ *    checks shared by the tests of libwavetable
+ *
+ *  tests.h
+ *
+ *  Every test is a function counting its failed checks through CHECK;
+ *  tests.c runs the one named on the command line, or all of them, and
+ *  ctest registers each by name.
+ */
+
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <stdio.h>
+
+extern int checkFailures;
+
+// report a failed condition with its location, and carry on
+#define CHECK(condition)                                             \
+  do {                                                               \
+    if (!(condition)) {                                              \
+      fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__,     \
+              #condition);                                           \
+      checkFailures++;                                               \
+    }                                                                \
+  } while (0)
+
+void testRingBuffer(void);
+void testScheduler(void);
+void testWavWriter(void);
+void testOscKernels(void);
+void testVoicePool(void);
+void testGraph(void);
+void testUnison(void);
+
+#endif  // TESTS_H
@@ -0,0 +1,80 @@
+/**
+ *  Purpose:
+ *    the unison stack balanced between the channels, and its note ramps
+ *
+ *  unisontest.c
+ */
+
+#include <math.h>
+#include <string.h>
+#include "builtin.h"
+#include "tests.h"
+#include "unison.h"
+
+#define FRAMES 1000  // longer than a ramp
+
+static unisonwave u;
+static float out[2 * FRAMES];
+
+// the copies of every count carry as much power left as right
+static void balance(void) {
+  const float *sine = builtinSine();
+  double left, right;
+  int copies, c;
+
+  for (copies = 2; copies <= OSC_UNISON_MAX; copies++) {
+    unisonInit(&u, sine, BUILTIN_TABLE_BITS, copies, 440.f, 1.f, 48000.);
+    left = right = 0.;
+    for (c = 0; c < copies; c++) {
+      left += (double)u.left[c] * u.left[c];
+      right += (double)u.right[c] * u.right[c];
+    }
+    CHECK(fabs(left - right) < 1e-6);
+    CHECK(fabs(left + right - 1.) < 1e-5);
+  }
+}
+
+// notes glide in and out, and only a silent stack gets new phases
+static void ramp(void) {
+  uint32_t phase[OSC_UNISON_MAX];
+  event e = {0};
+  double sum = 0.;
+  unsigned long i;
+  int c;
+
+  unisonInit(&u, builtinSine(), BUILTIN_TABLE_BITS, 8, 440.f, 0.f, 48000.);
+  for (c = 0; c < u.copies; c++) sum += u.unitLeft[c];
+  memcpy(phase, u.phase, sizeof(phase));
+  e.type = EVENT_NOTE_ON;
+  e.value = 440.f;
+  e.amplitude = 1.f;
+  unisonEventHandler(&e, &u);
+  CHECK(memcmp(phase, u.phase, sizeof(phase)) != 0);
+  unisonRender(&u, out, FRAMES);
+  for (i = 0; i <= u.rampFrames; i++)
+    CHECK(fabsf(out[2 * i]) <= sum * i / u.rampFrames + 1e-6);
+  CHECK(u.rampLeft == 0 && u.amplitude == 1.f);
+  CHECK(u.left[1] == u.unitLeft[1] && u.right[1] == u.unitRight[1]);
+
+  // a note over the release glides back up from where it got to
+  e.type = EVENT_NOTE_OFF;
+  unisonEventHandler(&e, &u);
+  unisonRender(&u, out, u.rampFrames / 2);
+  CHECK(u.amplitude > .4f && u.amplitude < .6f);
+  memcpy(phase, u.phase, sizeof(phase));
+  e.type = EVENT_NOTE_ON;
+  unisonEventHandler(&e, &u);
+  CHECK(memcmp(phase, u.phase, sizeof(phase)) == 0);
+  CHECK(u.rampLeft == u.rampFrames);
+
+  e.type = EVENT_NOTE_OFF;
+  unisonEventHandler(&e, &u);
+  unisonRender(&u, out, FRAMES);
+  CHECK(u.amplitude == 0.f && u.left[0] == 0.f);
+  for (i = u.rampFrames; i < FRAMES; i++) CHECK(out[2 * i] == 0.f);
+}
+
+void testUnison(void) {
+  balance();
+  ramp();
+}
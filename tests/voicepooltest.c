@@ -0,0 +1,87 @@
+/**
+ *  Purpose:
+ *    the voice pool rendering bit identically on a workerpool
+ *
+ *  voicepooltest.c
+ */
+
+#include <math.h>
+#include <string.h>
+#include "builtin.h"
+#include "tests.h"
+#include "voicepool.h"
+
+#define FRAMES 1000  // several chunks, the last one partial
+#define BLOCKS 6
+
+static voicepool single, parallel;
+static float expected[2 * FRAMES], actual[2 * FRAMES];
+
+// the same notes on both pools, more than fit so some are stolen
+static void play(voicepool *pool, int block) {
+  int k;
+
+  for (k = 0; k < 40; k++)
+    voicePoolNoteOnKey(pool, k % 12, 55.f * (1 + k % 16) + block, .01f);
+  voicePoolNoteOffKey(pool, block % 12);
+  voicePoolNoteOffKey(pool, (block + 5) % 12);
+}
+
+static void compare(int threads, const mipmap *bandlimited) {
+  workerpool workers;
+  int b;
+
+  CHECK(workerPoolInit(&workers, threads, NULL) == 0);
+  voicePoolInit(&single, builtinSine(), BUILTIN_TABLE_BITS, 48000., 200);
+  voicePoolInit(&parallel, builtinSine(), BUILTIN_TABLE_BITS, 48000., 200);
+  single.bandlimited = parallel.bandlimited = bandlimited;
+  parallel.workers = &workers;
+
+  for (b = 0; b < BLOCKS; b++) {
+    play(&single, b);
+    play(&parallel, b);
+    voicePoolRender(&single, expected, FRAMES);
+    voicePoolRender(&parallel, actual, FRAMES);
+    CHECK(memcmp(expected, actual, sizeof(expected)) == 0);
+    CHECK(single.activeCount == parallel.activeCount);
+  }
+  workerPoolFree(&workers);
+}
+
+// a released voice fades out within a straight line to 0, then is freed
+static void release(void) {
+  unsigned long i;
+  float bound;
+  int id;
+
+  voicePoolInit(&single, builtinSine(), BUILTIN_TABLE_BITS, 48000., 8);
+  id = voicePoolNoteOn(&single, 440.f, .5f);
+  voicePoolRender(&single, expected, 10);
+  voicePoolNoteOff(&single, id);
+  CHECK(single.activeCount == 1);
+  voicePoolRender(&single, expected, single.releaseFrames + 1);
+  for (i = 0; i <= single.releaseFrames; i++) {
+    bound = .5f * (1.f - (float)i / single.releaseFrames) + 1e-6f;
+    CHECK(fabsf(expected[2 * i]) <= bound);
+  }
+  CHECK(single.activeCount == 0);
+
+  // silent voices, whose step is -0 or underflows to 0, are freed too
+  voicePoolNoteOff(&single, voicePoolNoteOn(&single, 440.f, 0.f));
+  voicePoolNoteOff(&single, voicePoolNoteOn(&single, 440.f, 1e-44f));
+  CHECK(single.activeCount == 2);
+  voicePoolRender(&single, expected, single.releaseFrames);
+  CHECK(single.activeCount == 0);
+}
+
+void testVoicePool(void) {
+  mipmap saw;
+  int threads;
+
+  builtinMipmap(&saw, WAVEFORM_SAW);
+  for (threads = 1; threads <= 4; threads++) {
+    compare(threads, NULL);
+    compare(threads, &saw);
+  }
+  release();
+}
@@ -0,0 +1,145 @@
+/**
+ *  Purpose:
+ *    the bytes of the WAV header and its upgrade to RF64
+ *
+ *  wavwritertest.c
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tests.h"
+#include "wavwriter.h"
+
+#define HEADER_BYTES 94
+#define FRAMES 1000
+
+static uint32_t get32(const unsigned char *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+         (uint32_t)p[3] << 24;
+}
+
+static uint64_t get64(const unsigned char *p) {
+  return (uint64_t)get32(p) | (uint64_t)get32(p + 4) << 32;
+}
+
+static unsigned get16(const unsigned char *p) { return p[0] | p[1] << 8; }
+
+// a file name for the writer, removed again by the caller
+static int temporaryPath(char *path, size_t size) {
+  const char *dir = getenv("TMPDIR");
+  int fd;
+
+  snprintf(path, size, "%s/wavwritertestXXXXXX", dir != NULL ? dir : "/tmp");
+  fd = mkstemp(path);
+  if (fd < 0) return -1;
+  close(fd);
+  return 0;
+}
+
+// write frames of a known ramp through the offline sink, in uneven pieces
+static void writeFrames(wavwriter *w, unsigned long frames) {
+  static float samples[2 * FRAMES];
+  unsigned long i, n;
+
+  for (i = 0; i < 2 * frames; i++) samples[i] = (float)i / (2 * FRAMES);
+  for (i = 0; i < frames; i += n) {
+    n = frames - i < 77 ? frames - i : 77;
+    CHECK(wavWriterSink(samples + 2 * i, n, 2, w) == 0);
+  }
+}
+
+// the header fields shared by both forms, and the samples after it
+static void checkCommon(const unsigned char *h, unsigned long frames) {
+  float sample;
+  unsigned long i;
+
+  CHECK(memcmp(h + 8, "WAVE", 4) == 0);
+  CHECK(get32(h + 16) == 28);  // JUNK and ds64 take the same room
+  CHECK(memcmp(h + 48, "fmt ", 4) == 0 && get32(h + 52) == 18);
+  CHECK(get16(h + 56) == 3);  // WAVE_FORMAT_IEEE_FLOAT
+  CHECK(get16(h + 58) == 2);
+  CHECK(get32(h + 60) == 48000);
+  CHECK(get32(h + 64) == 48000 * 8);
+  CHECK(get16(h + 68) == 8 && get16(h + 70) == 32);
+  CHECK(get16(h + 72) == 0);  // no extension
+  CHECK(memcmp(h + 74, "fact", 4) == 0 && get32(h + 78) == 4);
+  CHECK(memcmp(h + 86, "data", 4) == 0);
+  for (i = 0; i < 2 * frames; i++) {
+    memcpy(&sample, h + HEADER_BYTES + 4 * i, 4);
+    CHECK(sample == (float)i / (2 * FRAMES));
+  }
+}
+
+// the whole file, NULL if it does not have the expected length
+static unsigned char *readFile(const char *path, size_t bytes) {
+  unsigned char *data = malloc(bytes + 1);
+  FILE *file = fopen(path, "rb");
+  size_t n = 0;
+
+  if (data != NULL && file != NULL) n = fread(data, 1, bytes + 1, file);
+  if (file != NULL) fclose(file);
+  CHECK(n == bytes);
+  if (n == bytes) return data;
+  free(data);
+  return NULL;
+}
+
+static void plainWave(const char *path) {
+  const uint32_t dataBytes = FRAMES * 8;
+  wavwriter w;
+  unsigned char *h, zero[28] = {0};
+
+  CHECK(wavWriterOpen(&w, path, 2, 48000., .01) == 0);
+  writeFrames(&w, FRAMES);
+  CHECK(wavWriterClose(&w) == 0);
+  h = readFile(path, HEADER_BYTES + dataBytes);
+  if (h == NULL) return;
+  CHECK(memcmp(h, "RIFF", 4) == 0);
+  CHECK(get32(h + 4) == HEADER_BYTES - 8 + dataBytes);
+  CHECK(memcmp(h + 12, "JUNK", 4) == 0 && memcmp(h + 20, zero, 28) == 0);
+  CHECK(get32(h + 82) == FRAMES);
+  CHECK(get32(h + 90) == dataBytes);
+  checkCommon(h, FRAMES);
+  free(h);
+}
+
+// the file is too large for RIFF sizes once it has more than 4 GB of
+// samples; the writer only counts what it wrote, so start the count there
+// instead of writing them all
+static void rf64(const char *path) {
+  const uint64_t skipped = 5ull << 30, written = 10 * 8;
+  const uint64_t dataBytes = skipped + written;
+  wavwriter w;
+  unsigned char *h;
+
+  CHECK(wavWriterOpen(&w, path, 2, 48000., .01) == 0);
+  // the disk thread only adds to it after a write, none is queued yet
+  w.dataBytes = skipped;
+  writeFrames(&w, 10);
+  CHECK(wavWriterClose(&w) == 0);
+  h = readFile(path, HEADER_BYTES + written);
+  if (h == NULL) return;
+  CHECK(memcmp(h, "RF64", 4) == 0 && get32(h + 4) == 0xFFFFFFFF);
+  CHECK(memcmp(h + 12, "ds64", 4) == 0);
+  CHECK(get64(h + 20) == HEADER_BYTES - 8 + dataBytes);
+  CHECK(get64(h + 28) == dataBytes);
+  CHECK(get64(h + 36) == dataBytes / 8);
+  CHECK(get32(h + 44) == 0);  // no table of other chunk sizes
+  CHECK(get32(h + 82) == 0xFFFFFFFF);
+  CHECK(get32(h + 90) == 0xFFFFFFFF);
+  checkCommon(h, 10);
+  free(h);
+}
+
+void testWavWriter(void) {
+  char path[256];
+
+  CHECK(temporaryPath(path, sizeof(path)) == 0);
+  plainWave(path);
+  rf64(path);
+  unlink(path);
+}
@@ -0,0 +1,84 @@
+/**
+ *  Purpose:
+ *    generate the built-in wavetables of builtin.h as C source
+ *
+ *  usage:
+ *    gentables output.c
+ *    run by the build, BUILTIN_TABLE_BITS is set as for libwavetable
+ *
+ *  gentables.c
+ *
+ *  Computes the sine of filltable and the mipmaps of mipmapInitWaveform
+ *  with the library's own code and prints every float as an exact
+ *  hexadecimal literal, so the compiled-in tables hold the values the
+ *  library would compute at startup.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "builtin.h"
+
+#define TWOPI (6.283185307179586)
+
+static const char *shapeNames[WAVEFORM_COUNT] = {"sine", "saw", "square",
+                                                 "triangle"};
+
+static void printRow(FILE *file, const float *row) {
+  int i;
+
+  fprintf(file, "{");
+  for (i = 0; i < BUILTIN_STRIDE; i++)
+    fprintf(file, "%s%af,", i % 4 == 0 ? "\n    " : " ", (double)row[i]);
+  fprintf(file, "}");
+}
+
+int main(int argc, char *argv[]) {
+  float sine[BUILTIN_STRIDE];
+  const double twopioverlength = TWOPI / BUILTIN_TABLE_LENGTH;  // as filltable
+  mipmap m;
+  FILE *file;
+  int i, l, w;
+
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s output.c\n", argv[0]);
+    return 1;
+  }
+  file = fopen(argv[1], "w");
+  if (file == NULL) {
+    fprintf(stderr, "Error: cannot open %s.\n", argv[1]);
+    return 1;
+  }
+
+  fprintf(file,
+          "/* generated by tools/gentables.c, %d point tables, do not edit */"
+          "\n\n#include \"builtin.h\"\n\n",
+          BUILTIN_TABLE_LENGTH);
+
+  for (i = 0; i < BUILTIN_TABLE_LENGTH; i++)
+    sine[WAVETABLE_GUARD + i] = sin(i * twopioverlength);
+  wavetableGuard(sine + WAVETABLE_GUARD, BUILTIN_TABLE_LENGTH);
+  fprintf(file, "const float builtinSineStorage[BUILTIN_STRIDE] = ");
+  printRow(file, sine);
+  fprintf(file, ";\n\n");
+
+  fprintf(file,
+          "const float builtinMipmapStorage[WAVEFORM_COUNT][BUILTIN_TABLE_BITS]"
+          "\n                                [BUILTIN_STRIDE] = {\n");
+  for (w = 0; w < WAVEFORM_COUNT; w++) {
+    if (mipmapInitWaveform(&m, (waveform)w, BUILTIN_TABLE_BITS) != 0) {
+      fprintf(stderr, "Error: cannot build the %s tables.\n", shapeNames[w]);
+      return 1;
+    }
+    fprintf(file, "  /* %s */\n  {", shapeNames[w]);
+    for (l = 0; l < m.levels; l++) {
+      fprintf(file, "\n  /* level %d */\n  ", l);
+      printRow(file, m.level[l] - WAVETABLE_GUARD);
+      fprintf(file, ",");
+    }
+    fprintf(file, "},\n");
+    mipmapFree(&m);
+  }
+  fprintf(file, "};\n");
+
+  return fclose(file) == 0 ? 0 : 1;
+}
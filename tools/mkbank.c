@@ -0,0 +1,102 @@
+/**
+ *  Purpose:
+ *    build a wavetable bank file from raw single cycle recordings
+ *
+ *  usage:
+ *    mkbank [-b tableBits] bank.wtb table.raw...
+ *    every input is raw float32 mono holding one or more frames of
+ *    2^tableBits samples (default 11, 2048 like Serum), it becomes a table
+ *    named after the file
+ *
+ *  mkbank.c
+ *
+ *  The mipmaps and guard points of every frame are computed here once,
+ *  so playing from the bank (see wavebank.h) only maps the file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "wavebank.h"
+
+// the whole file, a multiple of frameLength floats, NULL on error
+static float *readFrames(const char *path, size_t frameLength, int *frames) {
+  FILE *file = fopen(path, "rb");
+  float *samples = NULL;
+  long bytes;
+
+  if (file == NULL) return NULL;
+  if (fseek(file, 0, SEEK_END) == 0 && (bytes = ftell(file)) > 0 &&
+      bytes % (frameLength * sizeof(float)) == 0 &&
+      fseek(file, 0, SEEK_SET) == 0) {
+    samples = malloc((size_t)bytes);
+    if (samples != NULL &&
+        fread(samples, 1, (size_t)bytes, file) != (size_t)bytes) {
+      free(samples);
+      samples = NULL;
+    }
+    *frames = (int)(bytes / (frameLength * sizeof(float)));
+  }
+  fclose(file);
+  return samples;
+}
+
+int main(int argc, char *argv[]) {
+  wavebanksource *tables;
+  char (*names)[WAVEBANK_NAME_LENGTH];
+  const char *base;
+  char *dot;
+  int opt, tableBits = 11, count, t, result = 0;
+
+  while ((opt = getopt(argc, argv, "b:")) != -1) {
+    if (opt == 'b' && (tableBits = atoi(optarg)) >= 2 && tableBits <= 20)
+      continue;
+    fprintf(stderr, "usage: %s [-b tableBits] bank.wtb table.raw...\n",
+            argv[0]);
+    return 1;
+  }
+  if (optind + 2 > argc) {
+    fprintf(stderr, "usage: %s [-b tableBits] bank.wtb table.raw...\n",
+            argv[0]);
+    return 1;
+  }
+
+  count = argc - optind - 1;
+  tables = calloc((size_t)count, sizeof(*tables));
+  names = calloc((size_t)count, sizeof(*names));
+  if (tables == NULL || names == NULL) {
+    fprintf(stderr, "Error: out of memory.\n");
+    return 1;
+  }
+  for (t = 0; t < count; t++) {
+    const char *path = argv[optind + 1 + t];
+
+    base = strrchr(path, '/');
+    base = base != NULL ? base + 1 : path;
+    strncpy(names[t], base, WAVEBANK_NAME_LENGTH - 1);
+    dot = strrchr(names[t], '.');
+    if (dot != NULL) *dot = '\0';
+    tables[t].name = names[t];
+    tables[t].cycles = readFrames(path, (size_t)1 << tableBits,
+                                  &tables[t].frames);
+    if (tables[t].cycles == NULL) {
+      fprintf(stderr, "Error: cannot read %s as frames of %d samples.\n",
+              path, 1 << tableBits);
+      result = 1;
+      break;
+    }
+    printf("%s: %d frames\n", tables[t].name, tables[t].frames);
+  }
+
+  if (result == 0 &&
+      waveBankWrite(argv[optind], tableBits, tables, count) != 0) {
+    fprintf(stderr, "Error: cannot write %s.\n", argv[optind]);
+    result = 1;
+  }
+
+  for (t = 0; t < count; t++) free((void *)tables[t].cycles);
+  free(tables);
+  free(names);
+  return result;
+}
@@ -0,0 +1,70 @@
+#!/bin/sh
+#
+#  Purpose:
+#    profile guided build of libwavetable and the demos
+#
+#  usage:
+#    tools/pgo.sh [build-root [cmake options...]]   (in the repository root)
+#
+#  Builds the tree twice under build-root (default build-pgo):
+#
+#    plain/  the normal optimized build
+#    pgo/    built with WAVETABLE_PGO=GENERATE, trained by running
+#            bench/oscworkload, then rebuilt in place with WAVETABLE_PGO=USE
+#
+#  and prints the workload timings of both side by side, also written to
+#  build-root/pgo-report.txt. Extra cmake options (e.g. -DWAVETABLE_LTO=ON)
+#  go to both builds. TRAIN_SECONDS and REPORT_SECONDS set the audio
+#  rendered per workload case for training and for the comparison.
+
+set -e
+
+root=${1:-build-pgo}
+[ $# -gt 0 ] && shift
+train=${TRAIN_SECONDS:-5}
+seconds=${REPORT_SECONDS:-10}
+jobs=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 2)
+
+mkdir -p "$root"
+root=$(cd "$root" && pwd)
+profile="$root/pgo/profile"
+
+echo "== plain build"
+cmake -S . -B "$root/plain" -DWAVETABLE_PGO=OFF "$@" >/dev/null
+cmake --build "$root/plain" -j "$jobs" >/dev/null
+
+echo "== instrumented build"
+rm -rf "$profile"
+cmake -S . -B "$root/pgo" -DWAVETABLE_PGO=GENERATE \
+  -DWAVETABLE_PGO_DIR="$profile" "$@" >/dev/null
+cmake --build "$root/pgo" -j "$jobs" >/dev/null
+
+echo "== training with oscworkload -t $train"
+"$root/pgo/oscworkload" -t "$train" >/dev/null
+# clang writes raw profiles that have to be merged, gcc uses its .gcda as is
+if ls "$profile"/*.profraw >/dev/null 2>&1; then
+  llvm-profdata merge -output="$profile/default.profdata" \
+    "$profile"/*.profraw
+fi
+
+# same build directory, so gcc finds the profile of every object again
+echo "== profile guided build"
+cmake -S . -B "$root/pgo" -DWAVETABLE_PGO=USE "$@" >/dev/null
+cmake --build "$root/pgo" -j "$jobs" >/dev/null
+
+echo "== comparing with oscworkload -t $seconds"
+"$root/plain/oscworkload" -t "$seconds" -o "$root/plain.csv"
+"$root/pgo/oscworkload" -t "$seconds" -o "$root/pgo.csv"
+
+awk -F, '
+  FNR == 1 { next }
+  NR == FNR { plain[$1] = $2; order[++n] = $1; next }
+  { pgo[$1] = $2 }
+  END {
+    printf "%-16s %12s %12s %8s\n", "case", "plain ns", "pgo ns", "speedup"
+    for (i = 1; i <= n; i++) {
+      c = order[i]
+      printf "%-16s %12.2f %12.2f %7.1f%%\n", c, plain[c], pgo[c],
+             100 * (plain[c] / pgo[c] - 1)
+    }
+  }' "$root/plain.csv" "$root/pgo.csv" | tee "$root/pgo-report.txt"